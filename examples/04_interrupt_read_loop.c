@@ -0,0 +1,80 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include <pi_MCP2515.h>
+#include <stdio.h>
+
+int
+main(void)
+{
+	pi_mcp2515_t *mcp2515;
+	pi_mcp2515_can_frame_t frame;
+	int res;
+	uint8_t i;
+
+	/* Init, reset, and configure the MCP2515 as in 01_init_and_read_loop.c */
+	mcp2515_init(&mcp2515, 0, 19, 16, 18, 17, 10000000, 8);
+	mcp2515_reset(mcp2515);
+	mcp2515_bitrate_simplified(mcp2515, 500);
+
+	/* The MCP2515 INT pin goes low whenever one of the enabled interrupts is flagged, and stays low until every
+	 * enabled flag is cleared. Here, it is only the two RX buffer full interrupts. Reading a message from an RX buffer
+	 * clears its flag.
+	 */
+	mcp2515_interrupts_enable(mcp2515, PI_MCP2515_CANINTE_RX0IE | PI_MCP2515_CANINTE_RX1IE);
+
+	/* Set up the GPIO pin connected to INT, which is 20 here. If this fails, `mcp2515_int_wait` still works, but it
+	 * falls back to checking the interrupt flags over SPI.
+	 */
+	if (mcp2515_int_init(mcp2515, 20) != 0)
+		fprintf(stderr, "mcp2515_int_init() failed, falling back to polling\n");
+
+	mcp2515_reqop(mcp2515, PI_MCP2515_REQOP_NORMAL);
+
+	for (;;) {
+		/* Wait for up to a second for an interrupt. Unlike the loop in 01_init_and_read_loop.c, nothing is sent
+		 * to the MCP2515 while waiting, so an idle bus costs nothing.
+		 *
+		 * On Linux, `mcp2515_int_fd` also provides a file descriptor for the INT pin to use with poll(2) when
+		 * there are other things to wait for at the same time.
+		 */
+		res = mcp2515_int_wait(mcp2515, 1000);
+		if (res < 0) {
+			fprintf(stderr, "mcp2515_int_wait() returned %d\n", res);
+			break;
+		} else if (res == 0)
+			continue;
+
+		/* Read until both RX buffers are empty, at which point INT is released again. */
+		while (mcp2515_can_message_received(mcp2515)) {
+			memset(&frame, 0, sizeof(frame));
+
+			if ((res = mcp2515_can_message_read(mcp2515, &frame)) != 0) {
+				fprintf(stderr, "mcp2515_can_message_read() returned %d\n", res);
+				break;
+			}
+
+			printf("CAN msg retrieved:\n  id:  0x%08lx\n  dlc: 0x%02x\n  CAN data:\n   ", frame.id,
+			    frame.dlc);
+			for (i = 0; i < frame.dlc; i++)
+				printf(" 0x%02x", frame.payload[i]);
+			printf("\n\n");
+		}
+	}
+
+	return (0);
+}
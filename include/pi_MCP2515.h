@@ -26,10 +26,22 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define PI_MCP2515_CAN_FRAME_PAYLOAD_MAX 8
 
+#define PI_MCP2515_REGISTER_SPACE_LEN 128 /**< @brief Size of the MCP2515 register address space. */
+#define PI_MCP2515_IOV_MAX 16 /**< @brief Maximum number of buffers in a single register burst. */
+
+/**
+ * @brief A buffer for scatter-gather register bursts (see mcp2515_register_readv and mcp2515_register_writev).
+ */
+typedef struct {
+	uint8_t *base;
+	uint8_t len;
+} pi_mcp2515_iovec_t;
+
 /**
  * @brief CAN bus frame data structure.
  */
@@ -41,6 +53,29 @@ typedef struct {
 	uint8_t payload[PI_MCP2515_CAN_FRAME_PAYLOAD_MAX];
 } pi_mcp2515_can_frame_t;
 
+/**
+ * @brief A CAN bus frame already laid out as in the MCP2515's TX buffer registers, from SIDH through to D7.
+ *
+ * Treat this as opaque. Convert with mcp2515_wire_frame_encode and mcp2515_wire_frame_decode, so a frame sent many
+ * times only needs encoding once.
+ */
+typedef struct {
+	uint8_t regs[5 + PI_MCP2515_CAN_FRAME_PAYLOAD_MAX];
+} pi_mcp2515_wire_frame_t;
+
+/**
+ * @brief One segment of an SPI transaction, as handed to a transport.
+ *
+ * A NULL `tx` clocks out dummy bytes, and a NULL `rx` discards whatever is clocked in. `cs_change` marks the last
+ * segment of an MCP2515 command, after which chip select is released before the next segment (if any).
+ */
+typedef struct {
+	const uint8_t *tx;
+	uint8_t *rx;
+	uint8_t len;
+	bool cs_change;
+} pi_mcp2515_spi_seg_t;
+
 /**
  * @defgroup piMCP2515_register_addresses Register Addresses
  * @brief These definitions hold the MCP2515 register addresses.
@@ -55,6 +90,7 @@ typedef enum {
 	PI_MCP2515_RGSTR_RXF5SIDH = 0x18,
 	PI_MCP2515_RGSTR_RXM0SIDH = 0x20,
 	PI_MCP2515_RGSTR_RXM1SIDH = 0x24,
+	PI_MCP2515_RGSTR_BFPCTRL = 0x0C,
 	PI_MCP2515_RGSTR_CANSTAT = 0x0E,
 	PI_MCP2515_RGSTR_CANCTRL = 0x0F,
 	PI_MCP2515_RGSTR_CANINTE = 0x2B,
@@ -113,10 +149,16 @@ typedef enum {
 #define PI_MCP2515_INSTR_LOAD_TX1 0x42
 #define PI_MCP2515_INSTR_LOAD_TX2 0x44
 
+/* These load a TX buffer starting at the first data byte, leaving the ID and DLC as they are. */
+#define PI_MCP2515_INSTR_LOAD_TX0_D0 0x41
+#define PI_MCP2515_INSTR_LOAD_TX1_D0 0x43
+#define PI_MCP2515_INSTR_LOAD_TX2_D0 0x45
+
 #define PI_MCP2515_INSTR_READ_RX0 0x90
 #define PI_MCP2515_INSTR_READ_RX1 0x94
 
 /* These can be `|`'d together to apply the RTS instruction to multiple buffers. */
+#define PI_MCP2515_INSTR_RTS 0x80 /**< @brief SPI interface RTS instruction, without any buffers selected. */
 #define PI_MCP2515_INSTR_RTS_TX0 0x81
 #define PI_MCP2515_INSTR_RTS_TX1 0x82
 #define PI_MCP2515_INSTR_RTS_TX2 0x84
@@ -140,11 +182,17 @@ typedef enum {
 
 /* CTRL Definitions */
 #define PI_MCP2515_CTRL_RTR 0x08
+#define PI_MCP2515_CTRL_TXP_MASK 0x03
 #define PI_MCP2515_CTRL_TXREQ 0x08
 #define PI_MCP2515_CTRL_TXERR 0x10
 #define PI_MCP2515_CTRL_MLOA 0x20
 #define PI_MCP2515_CTRL_ABTF 0x40
 #define PI_MCP2515_RXBCTRL_STDEXT_MASK 0x60
+#define PI_MCP2515_RXBCTRL_RXRTR 0x08
+#define PI_MCP2515_RXB0CTRL_BUKT 0x04
+#define PI_MCP2515_RXB0CTRL_BUKT1 0x02
+#define PI_MCP2515_RXB0CTRL_FILHIT 0x01
+#define PI_MCP2515_RXB1CTRL_FILHIT 0x07
 
 /**
  * @defgroup piMCP2515_eflg EFLG Register Flags.
@@ -164,6 +212,7 @@ typedef enum {
 
 #define PI_MCP2515_RXBSIDL_IDE 0x08
 #define PI_MCP2515_RXBSIDL_SRR 0x10
+#define PI_MCP2515_TXBSIDL_EXIDE 0x08
 
 /**
  * @defgroup piMCP2515_rx_status `RX STATUS` SPI command flags.
@@ -173,15 +222,25 @@ typedef enum {
 #define PI_MCP2515_RX_STATUS_RCV_RXB0 0x40 /**< @brief RXB0 has a message. */
 #define PI_MCP2515_RX_STATUS_RCV_RXB1 0x80 /**< @brief RXB1 has a message. */
 #define PI_MCP2515_RX_STATUS_RCV_ALL 0xc0 /**< @brief Both RX buffers have messages. A bitwise OR of both RXBn flags. */
-#define PI_MCP2515_RX_STATUS_RTR 0x08
-#define PI_MCP2515_RX_STATUS_EID 0x10
+#define PI_MCP2515_RX_STATUS_RTR 0x08 /**< @brief The frame is a remote frame. */
+#define PI_MCP2515_RX_STATUS_EID 0x10 /**< @brief The frame has an extended ID. */
+#define PI_MCP2515_RX_STATUS_TYPE_MASK 0x18 /**< @brief Mask for the frame type, a combination of EID and RTR. */
+#define PI_MCP2515_RX_STATUS_FILHIT_MASK 0x07 /**< @brief Mask for the filter match. */
+#define PI_MCP2515_RX_STATUS_FILHIT_RXF0_RXB1 0x06 /**< @brief Matched RXF0, and rolled over into RXB1. */
+#define PI_MCP2515_RX_STATUS_FILHIT_RXF1_RXB1 0x07 /**< @brief Matched RXF1, and rolled over into RXB1. */
+/** @brief Get the filter matched (as an mcp2515_rxf_t) from an RX status value, including for rolled over frames. */
+#define PI_MCP2515_RX_STATUS_RXF(x) ((((x) & PI_MCP2515_RX_STATUS_FILHIT_MASK) < PI_MCP2515_RX_STATUS_FILHIT_RXF0_RXB1) \
+    ? ((x) & PI_MCP2515_RX_STATUS_FILHIT_MASK) : (((x) & PI_MCP2515_RX_STATUS_FILHIT_MASK) - PI_MCP2515_RX_STATUS_FILHIT_RXF0_RXB1))
 /** @} */
 
 /* Status Definitions */
 #define PI_MCP2515_STATUS_RX0BF 0x01
 #define PI_MCP2515_STATUS_RX1BF 0x02
+#define PI_MCP2515_STATUS_TX0REQ 0x04
 #define PI_MCP2515_STATUS_TX0IF 0x08
+#define PI_MCP2515_STATUS_TX1REQ 0x10
 #define PI_MCP2515_STATUS_TX1IF 0x20
+#define PI_MCP2515_STATUS_TX2REQ 0x40
 #define PI_MCP2515_STATUS_TX2IF 0x80
 
 /**
@@ -197,6 +256,21 @@ typedef enum {
 #define PI_MCP2515_CANINTF_ERRIF 0x20 /**< @brief Error interrupt flag. */
 /** @} */
 
+/**
+ * @defgroup piMCP2515_caninte CANINTE Register Flags.
+ * @brief These definitions hold the flags in the CANINTE register, which select the interrupts that assert INT.
+ * @{
+ */
+#define PI_MCP2515_CANINTE_RX0IE 0x01 /**< @brief RXB0 full interrupt enable. */
+#define PI_MCP2515_CANINTE_RX1IE 0x02 /**< @brief RXB1 full interrupt enable. */
+#define PI_MCP2515_CANINTE_TX0IE 0x04 /**< @brief TXB0 empty interrupt enable. */
+#define PI_MCP2515_CANINTE_TX1IE 0x08 /**< @brief TXB1 empty interrupt enable. */
+#define PI_MCP2515_CANINTE_TX2IE 0x10 /**< @brief TXB2 empty interrupt enable. */
+#define PI_MCP2515_CANINTE_ERRIE 0x20 /**< @brief Error interrupt enable. */
+#define PI_MCP2515_CANINTE_WAKIE 0x40 /**< @brief Wake-up interrupt enable. */
+#define PI_MCP2515_CANINTE_MERRE 0x80 /**< @brief Message error interrupt enable. */
+/** @} */
+
 typedef enum {
 	PI_MCP2515_TXB0 = 0,
 	PI_MCP2515_TXB1 = 1,
@@ -232,11 +306,209 @@ typedef enum {
 
 typedef struct pi_mcp2515 pi_mcp2515_t;
 
+/**
+ * @brief Transport operations, which carry out all communication with the MCP2515 for a handle.
+ *
+ * `transfer` performs an SPI transaction made up of one or more MCP2515 commands (see pi_mcp2515_spi_seg_t), returning
+ * zero if success, otherwise non-zero. `free` (which may be NULL) releases anything held by the transport when the
+ * handle is freed.
+ */
+typedef struct {
+	int	(*transfer)(pi_mcp2515_t *, const pi_mcp2515_spi_seg_t *, uint8_t);
+	void	(*free)(pi_mcp2515_t *);
+} pi_mcp2515_transport_t;
+
+/**
+ * @brief A received CAN bus frame, along with where it was received (see mcp2515_can_message_read_rx).
+ *
+ * A frame which matched RXF0 or RXF1 but was received into RXB1 has rolled over from RXB0 (see
+ * mcp2515_filter_rollover).
+ */
+typedef struct {
+	pi_mcp2515_can_frame_t frame; /**< @brief The frame. */
+	mcp2515_rxb_t rxb; /**< @brief The RX buffer it was received into. */
+	mcp2515_rxf_t filhit; /**< @brief The filter it matched. */
+	uint64_t timestamp; /**< @brief When it was received, in nanoseconds of CLOCK_MONOTONIC (or since boot on the Pico). */
+	bool timestamp_edge; /**< @brief If @p timestamp is from the INT pin, rather than when the frame was first seen. */
+} pi_mcp2515_can_rx_frame_t;
+
+/**
+ * @brief What the RX thread does with a received frame when its ring is full.
+ */
+typedef enum {
+	PI_MCP2515_RX_OVERFLOW_DROP = 0, /**< @brief Read the frame from the MCP2515 and discard it. */
+	PI_MCP2515_RX_OVERFLOW_HOLD = 1, /**< @brief Leave the frame in the MCP2515 until there is room. */
+} mcp2515_rx_overflow_t;
+
+/**
+ * @brief RX thread counters (see mcp2515_rx_thread_stats).
+ */
+typedef struct {
+	uint32_t received; /**< @brief Frames put in the ring. */
+	uint32_t dropped; /**< @brief Frames discarded because the ring was full. */
+	uint32_t overruns; /**< @brief Frames lost by the MCP2515 itself, as counted by the RXnOVR error flags. */
+} pi_mcp2515_rx_thread_stats_t;
+
+/** @brief The most aligned blocks of IDs mcp2515_filter_compile can work with. */
+#define PI_MCP2515_FILTER_COMPILE_MAX 256
+
+/**
+ * @brief A range of CAN IDs for mcp2515_filter_compile to accept.
+ */
+typedef struct {
+	uint32_t first; /**< @brief The first ID. */
+	uint32_t last; /**< @brief The last ID, which may be the same as the first. */
+	bool extended_id; /**< @brief If the IDs are extended. */
+} pi_mcp2515_filter_range_t;
+
+/**
+ * @brief Masks and filters, as worked out by mcp2515_filter_compile.
+ */
+typedef struct {
+	uint32_t mask[2]; /**< @brief RXM0 and RXM1, laid out as extended IDs, with the standard ID bits at the top. */
+	uint32_t filter[6]; /**< @brief RXF0-RXF5, as IDs. */
+	bool extended_id[6]; /**< @brief If each filter is for extended IDs. */
+	uint32_t false_positives_std; /**< @brief How many standard IDs are accepted without being asked for. */
+	uint32_t false_positives_ext; /**< @brief How many extended IDs are accepted without being asked for. */
+} pi_mcp2515_filter_plan_t;
+
+/**
+ * @brief The order the TX queue sends messages in.
+ */
+typedef enum {
+	PI_MCP2515_TX_QUEUE_FIFO = 0, /**< @brief The order they were queued in. */
+	PI_MCP2515_TX_QUEUE_PRIORITY = 1, /**< @brief The order they would win arbitration on the bus in. */
+} mcp2515_tx_queue_order_t;
+
+/**
+ * @brief TX queue counters (see mcp2515_tx_queue_stats).
+ */
+typedef struct {
+	uint32_t queued; /**< @brief Messages waiting in the TX queue. */
+	uint32_t loaded; /**< @brief Messages in TX buffers, waiting to be sent. */
+	uint32_t sent; /**< @brief Messages sent. */
+	uint32_t failed; /**< @brief Messages whose send was aborted. */
+	uint32_t preempted; /**< @brief Messages aborted and queued again to make way for a more urgent message. */
+} pi_mcp2515_tx_queue_stats_t;
+
+/**
+ * @brief Runtime counters for a piMCP2515 handle (see mcp2515_stats_get).
+ */
+typedef struct {
+	uint64_t spi_transactions; /**< @brief SPI transactions with the MCP2515. */
+	uint64_t spi_bytes; /**< @brief Bytes clocked over SPI, in either direction. */
+	uint64_t syscalls; /**< @brief System calls made on the data path, for SPI, GPIO, and INT line access. */
+	uint64_t frames_rx; /**< @brief Messages read from the RX buffers, including any dropped by the software filter. */
+	uint64_t frames_tx; /**< @brief Messages sent. Mailbox sends count at the next send, batch sends at load. */
+	uint64_t rx_overruns; /**< @brief Times RX0OVR or RX1OVR was seen newly set in EFLG. */
+	uint64_t tx_errors; /**< @brief Sends seen to fail with TXERR, MLOA, or ABTF. */
+	uint64_t bus_off; /**< @brief Times the MCP2515 was seen newly gone bus-off. */
+} pi_mcp2515_stats_t;
+
+#define PI_MCP2515_TRACE_ARGS 4 /**< @brief How many arguments a trace event holds. */
+#define PI_MCP2515_TRACE_MAGIC 0x5432504DUL /**< @brief Identifies a trace file (see mcp2515_trace_save). */
+#define PI_MCP2515_TRACE_VERSION 1 /**< @brief The trace file format version. */
+
+/**
+ * @brief Trace event IDs, with the arguments each is recorded with (see mcp2515_trace_init).
+ *
+ * Frame headers are given as the SIDH, SIDL, EID8, and EID0 registers packed into one argument, SIDH in the top byte,
+ * followed by the DLC register.
+ */
+typedef enum {
+	PI_MCP2515_TRACE_SPI = 1, /**< @brief An SPI transaction: segments, bytes, result. */
+	PI_MCP2515_TRACE_STATUS = 2, /**< @brief A READ STATUS: status. */
+	PI_MCP2515_TRACE_RX_STATUS = 3, /**< @brief An RX STATUS: RX status. */
+	PI_MCP2515_TRACE_RX = 4, /**< @brief A frame read: RX buffer, header, DLC. */
+	PI_MCP2515_TRACE_TX_LOAD = 5, /**< @brief A frame loaded to send: TX buffer, header, DLC. */
+	PI_MCP2515_TRACE_TX_BUSY = 6, /**< @brief Too few TX buffers free: free TX buffers, TX buffers needed. */
+	PI_MCP2515_TRACE_TX_FAIL = 7, /**< @brief A blocking send failed: TX buffer, TXBnCTRL. */
+	PI_MCP2515_TRACE_TX_CLEAR = 8, /**< @brief TXnIF cleared: TX buffer. */
+	PI_MCP2515_TRACE_REQOP = 9, /**< @brief A mode change requested: REQOP. */
+	PI_MCP2515_TRACE_CNF = 10, /**< @brief Bit timing configured: CNF1, CNF2, CNF3. */
+	PI_MCP2515_TRACE_SHADOW = 11, /**< @brief A register shadow mismatch: register, shadow, value read. */
+	PI_MCP2515_TRACE_EFLG = 12, /**< @brief Overrun or bus-off flags newly set: EFLG. */
+} mcp2515_trace_event_id_t;
+
+/**
+ * @brief A trace event (see mcp2515_trace_snapshot).
+ */
+typedef struct {
+	uint64_t timestamp; /**< @brief When it was recorded, in nanoseconds on a monotonic clock. */
+	uint32_t seq; /**< @brief Its position in the trace, which skips any events overwritten before being read. */
+	uint16_t event; /**< @brief The event ID (see mcp2515_trace_event_id_t). */
+	uint16_t reserved; /**< @brief Always zero. */
+	uint32_t args[PI_MCP2515_TRACE_ARGS]; /**< @brief The event's arguments, with any unused zeroed. */
+} pi_mcp2515_trace_event_t;
+
+/**
+ * @brief The start of a trace file, followed by `count` events (see mcp2515_trace_save).
+ *
+ * Trace files are in the byte order of the system they were saved on.
+ */
+typedef struct {
+	uint32_t magic; /**< @brief PI_MCP2515_TRACE_MAGIC. */
+	uint16_t version; /**< @brief PI_MCP2515_TRACE_VERSION. */
+	uint16_t event_size; /**< @brief The size of each event. */
+	uint32_t count; /**< @brief How many events follow. */
+	uint32_t reserved; /**< @brief Always zero. */
+} pi_mcp2515_trace_header_t;
+
+/** @brief The most masks which can be registered with mcp2515_dispatch_register_mask. */
+#define PI_MCP2515_DISPATCH_MASKS_MAX 32
+
+/**
+ * @brief A handler for received CAN bus messages (see mcp2515_dispatch_register), given the handle, the message, and
+ * the pointer it was registered with.
+ */
+typedef void (*mcp2515_dispatch_handler_t)(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *, void *);
+
+/**
+ * @brief A handler for batches of received CAN bus messages (see mcp2515_dispatch_batch), given the handle, the
+ * messages, how many there are, and the pointer it was registered with.
+ */
+typedef void (*mcp2515_dispatch_batch_handler_t)(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *, size_t, void *);
+
+#define PI_MCP2515_BATCH_MAX 32 /**< @brief Maximum number of operations queued in a single batch. */
+#define PI_MCP2515_BATCH_CMD_MAX 14 /**< @brief Space for the instruction and operands of one batched operation. */
+
+/*! @cond DOXYGEN_IGNORE */
+struct mcp2515_batch_op {
+	uint8_t cmd[PI_MCP2515_BATCH_CMD_MAX];
+	uint8_t cmd_len;
+	const uint8_t *tx;
+	uint8_t *rx;
+	uint8_t data_len;
+};
+/*! @endcond */
+
+/**
+ * @brief A batch of MCP2515 operations, queued up to be carried out together in a single SPI transaction.
+ *
+ * See mcp2515_batch_init and mcp2515_batch_flush. Nothing in here should be accessed directly.
+ */
+typedef struct {
+	struct mcp2515_batch_op ops[PI_MCP2515_BATCH_MAX];
+	uint8_t count;
+} mcp2515_batch_t;
+
 uint32_t	mcp2515_can_id_build(uint32_t, bool);
 int		mcp2515_can_clear_txif(pi_mcp2515_t *, uint8_t);
 int		mcp2515_can_message_send(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *);
+int		mcp2515_can_message_send_async(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *, uint8_t *);
+int		mcp2515_can_tx_poll(pi_mcp2515_t *, uint8_t *, uint8_t *, uint8_t *);
+int		mcp2515_can_tx_abort(pi_mcp2515_t *, uint8_t);
+int		mcp2515_can_wire_send(pi_mcp2515_t *, const pi_mcp2515_wire_frame_t *);
+int		mcp2515_can_wire_send_async(pi_mcp2515_t *, const pi_mcp2515_wire_frame_t *, uint8_t *);
+int		mcp2515_can_message_send_burst(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *, uint8_t, uint8_t *);
 int		mcp2515_can_message_read(pi_mcp2515_t *, pi_mcp2515_can_frame_t *);
+int		mcp2515_can_message_read_rx(pi_mcp2515_t *, pi_mcp2515_can_rx_frame_t *);
+int		mcp2515_can_message_read_ordered(pi_mcp2515_t *, pi_mcp2515_can_rx_frame_t *);
+int		mcp2515_can_message_read_wire(pi_mcp2515_t *, pi_mcp2515_wire_frame_t *);
 int		mcp2515_can_message_read_rxb(pi_mcp2515_t *, mcp2515_rxb_t, pi_mcp2515_can_frame_t *);
+int		mcp2515_can_message_read_batch(pi_mcp2515_t *, pi_mcp2515_can_frame_t *, size_t, size_t *);
+int		mcp2515_can_message_read_select(pi_mcp2515_t *, bool (*)(uint8_t, void *), void *,
+    pi_mcp2515_can_frame_t *);
 bool		mcp2515_can_message_received(pi_mcp2515_t *);
 bool		mcp2515_can_message_received_rxb(pi_mcp2515_t *, mcp2515_rxb_t);
 void		mcp2515_rts(pi_mcp2515_t *, uint8_t);
@@ -244,21 +516,41 @@ void		mcp2515_rts(pi_mcp2515_t *, uint8_t);
 uint8_t		mcp2515_interrupts_get(pi_mcp2515_t *);
 uint8_t		mcp2515_interrupts_mask(pi_mcp2515_t *);
 void		mcp2515_interrupts_clear(pi_mcp2515_t *);
+int		mcp2515_interrupts_enable(pi_mcp2515_t *, uint8_t);
+int		mcp2515_int_init(pi_mcp2515_t *, uint8_t);
+int		mcp2515_int_wait(pi_mcp2515_t *, int);
+int		mcp2515_int_fd(const pi_mcp2515_t *);
 
 int	mcp2515_filter(pi_mcp2515_t *, mcp2515_rxf_t, uint32_t, bool);
 int	mcp2515_filter_mask(pi_mcp2515_t *, mcp2515_rxm_t, uint32_t, bool);
 int	mcp2515_filter_enable(pi_mcp2515_t *, bool);
 int	mcp2515_filter_enable_rxb(pi_mcp2515_t *, mcp2515_rxb_t, bool);
+int	mcp2515_filter_rollover(pi_mcp2515_t *, bool);
+int	mcp2515_filter_compile(const pi_mcp2515_filter_range_t *, size_t, pi_mcp2515_filter_plan_t *);
+bool	mcp2515_filter_plan_accepts(const pi_mcp2515_filter_plan_t *, uint32_t, bool);
+int	mcp2515_filter_plan_apply(pi_mcp2515_t *, const pi_mcp2515_filter_plan_t *);
+
+int		mcp2515_sw_filter_init(pi_mcp2515_t *);
+void		mcp2515_sw_filter_free(pi_mcp2515_t *);
+int		mcp2515_sw_filter_add(pi_mcp2515_t *, uint32_t, bool);
+int		mcp2515_sw_filter_add_range(pi_mcp2515_t *, const pi_mcp2515_filter_range_t *);
+void		mcp2515_sw_filter_remove(pi_mcp2515_t *, uint32_t, bool);
+void		mcp2515_sw_filter_clear(pi_mcp2515_t *);
+bool		mcp2515_sw_filter_accepts(const pi_mcp2515_t *, uint32_t, bool);
+uint32_t	mcp2515_sw_filter_rejected(const pi_mcp2515_t *);
 
 int		mcp2515_register_read(pi_mcp2515_t *, uint8_t *, uint8_t, mcp2515_rgstr_t);
 int		mcp2515_register_write(pi_mcp2515_t *, uint8_t[], uint8_t, mcp2515_rgstr_t);
 int		mcp2515_register_bitmod(pi_mcp2515_t *, uint8_t, uint8_t, mcp2515_rgstr_t);
+int		mcp2515_register_readv(pi_mcp2515_t *, const pi_mcp2515_iovec_t *, uint8_t, mcp2515_rgstr_t);
+int		mcp2515_register_writev(pi_mcp2515_t *, const pi_mcp2515_iovec_t *, uint8_t, mcp2515_rgstr_t);
 
 int		mcp2515_reset(pi_mcp2515_t *);
 int		mcp2515_reqop(pi_mcp2515_t *, mcp2515_reqop_t);
 mcp2515_reqop_t	mcp2515_reqop_get(pi_mcp2515_t *);
 
 uint8_t		mcp2515_status(pi_mcp2515_t *);
+uint8_t		mcp2515_rx_status(pi_mcp2515_t *);
 uint8_t		mcp2515_error_tx_count(pi_mcp2515_t *);
 uint8_t		mcp2515_error_rx_count(pi_mcp2515_t *);
 uint8_t		mcp2515_error_flags(pi_mcp2515_t *);
@@ -267,6 +559,7 @@ int		mcp2515_error_clear_errif(pi_mcp2515_t *);
 
 void		mcp2515_micro_sleep(uint64_t micro_s);
 uint64_t	mcp2515_osc_time(const pi_mcp2515_t *, uint32_t);
+uint64_t	mcp2515_timestamp_realtime(uint64_t);
 
 int		mcp2515_bitrate_default_16mhz_1000kbps(pi_mcp2515_t *);
 int		mcp2515_bitrate_default_8mhz_500kbps(pi_mcp2515_t *);
@@ -280,7 +573,65 @@ int	mcp2515_init(pi_mcp2515_t **, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, u
 int	mcp2515_cnf_set(pi_mcp2515_t *, uint8_t, uint8_t, uint8_t);
 uint8_t	mcp2515_cnf_get(pi_mcp2515_t *, uint8_t);
 
+void	mcp2515_batch_init(mcp2515_batch_t *);
+int	mcp2515_batch_register_read(mcp2515_batch_t *, uint8_t *, uint8_t, mcp2515_rgstr_t);
+int	mcp2515_batch_register_write(mcp2515_batch_t *, const uint8_t *, uint8_t, mcp2515_rgstr_t);
+int	mcp2515_batch_register_bitmod(mcp2515_batch_t *, uint8_t, uint8_t, mcp2515_rgstr_t);
+int	mcp2515_batch_status(mcp2515_batch_t *, uint8_t *);
+int	mcp2515_batch_load_tx(mcp2515_batch_t *, uint8_t, const pi_mcp2515_can_frame_t *);
+int	mcp2515_batch_rts(mcp2515_batch_t *, uint8_t);
+int	mcp2515_batch_flush(pi_mcp2515_t *, mcp2515_batch_t *);
+
+int	mcp2515_dispatch_init(pi_mcp2515_t *);
+void	mcp2515_dispatch_free(pi_mcp2515_t *);
+int	mcp2515_dispatch_register(pi_mcp2515_t *, uint32_t, bool, mcp2515_dispatch_handler_t, void *);
+int	mcp2515_dispatch_register_mask(pi_mcp2515_t *, uint32_t, uint32_t, bool, mcp2515_dispatch_handler_t, void *);
+int	mcp2515_dispatch_default(pi_mcp2515_t *, mcp2515_dispatch_handler_t, void *);
+int	mcp2515_dispatch_batch(pi_mcp2515_t *, mcp2515_dispatch_batch_handler_t, void *);
+int	mcp2515_dispatch_frame(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *);
+int	mcp2515_dispatch_poll(pi_mcp2515_t *, size_t *);
+
+int	mcp2515_tx_queue_init(pi_mcp2515_t *, uint32_t, mcp2515_tx_queue_order_t);
+void	mcp2515_tx_queue_free(pi_mcp2515_t *);
+int	mcp2515_tx_queue_push(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *);
+int	mcp2515_tx_queue_service(pi_mcp2515_t *);
+void	mcp2515_tx_queue_stats(const pi_mcp2515_t *, pi_mcp2515_tx_queue_stats_t *);
+
+void	mcp2515_stats_get(const pi_mcp2515_t *, pi_mcp2515_stats_t *);
+void	mcp2515_stats_reset(pi_mcp2515_t *);
+
+int	mcp2515_trace_init(pi_mcp2515_t *, uint32_t);
+void	mcp2515_trace_free(pi_mcp2515_t *);
+size_t	mcp2515_trace_snapshot(const pi_mcp2515_t *, pi_mcp2515_trace_event_t *, size_t);
+int	mcp2515_trace_save(const pi_mcp2515_t *, int);
+
+void	mcp2515_wire_frame_encode(const pi_mcp2515_can_frame_t *, pi_mcp2515_wire_frame_t *);
+void	mcp2515_wire_frame_decode(const pi_mcp2515_wire_frame_t *, pi_mcp2515_can_frame_t *);
+void	mcp2515_wire_frame_encode_batch(const pi_mcp2515_can_frame_t *, pi_mcp2515_wire_frame_t *, size_t);
+void	mcp2515_wire_frame_decode_batch(const pi_mcp2515_wire_frame_t *, pi_mcp2515_can_frame_t *, size_t);
+
+void	mcp2515_shadow_enable(pi_mcp2515_t *, bool);
+void	mcp2515_shadow_invalidate(pi_mcp2515_t *);
+int	mcp2515_shadow_verify(pi_mcp2515_t *);
+
+int	mcp2515_can_mailbox_bind(pi_mcp2515_t *, uint8_t, const pi_mcp2515_can_frame_t *, uint8_t);
+int	mcp2515_can_mailbox_send(pi_mcp2515_t *, uint8_t, const uint8_t *);
+void	mcp2515_can_mailbox_unbind(pi_mcp2515_t *, uint8_t);
+
+int	mcp2515_rx_thread_start(pi_mcp2515_t *, uint32_t, mcp2515_rx_overflow_t);
+void	mcp2515_rx_thread_stop(pi_mcp2515_t *);
+int	mcp2515_rx_thread_read(pi_mcp2515_t *, pi_mcp2515_can_frame_t *, int);
+int	mcp2515_rx_thread_read_rx(pi_mcp2515_t *, pi_mcp2515_can_rx_frame_t *, int);
+void	mcp2515_rx_thread_stats(const pi_mcp2515_t *, pi_mcp2515_rx_thread_stats_t *);
+
+int	mcp2515_init_transport(pi_mcp2515_t **, const pi_mcp2515_transport_t *, void *, uint8_t);
+void	*mcp2515_transport_ctx(const pi_mcp2515_t *);
+
+int	mcp2515_init_sim(pi_mcp2515_t **, uint8_t);
+int	mcp2515_sim_inject(pi_mcp2515_t *, const pi_mcp2515_can_frame_t *);
+
 void	mcp2515_conf_spi_devpath(pi_mcp2515_t *, char *);
+int	mcp2515_conf_spi_native_cs(pi_mcp2515_t *, bool);
 void	mcp2515_conf_gpio_devpath(pi_mcp2515_t *, char *);
 
 void	mcp2515_debug_enable(pi_mcp2515_t *, void (*)(char *, va_list));
@@ -0,0 +1,297 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+static struct mcp2515_batch_op	*batch_op_add(mcp2515_batch_t *, uint8_t);
+
+/**
+ * @brief Claim the next operation in a batch.
+ *
+ * @param batch the batch.
+ * @param instr the instruction of the operation.
+ * @return the operation, or NULL if the batch is full.
+ */
+static struct mcp2515_batch_op *
+batch_op_add(mcp2515_batch_t *batch, uint8_t instr)
+{
+	struct mcp2515_batch_op *op = NULL;
+
+	if (batch->count >= PI_MCP2515_BATCH_MAX)
+		goto end;
+
+	op = &batch->ops[batch->count++];
+	memset(op, 0, sizeof(*op));
+	op->cmd[0] = instr;
+	op->cmd_len = 1;
+
+end:
+	return (op);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_batch_functions Batch Functions
+ * @brief These functions queue up several operations to be carried out together.
+ *
+ * Each operation still gets its own assertion of chip select, exactly as it would if done on its own, but the whole
+ * batch is handed to the transport at once. With native chip select on Linux, this is a single syscall.
+ *
+ * Buffers given to a batch are not touched until the batch is flushed, so they must remain valid until then. Values
+ * read back are only available once mcp2515_batch_flush returns.
+ * @{
+ */
+/**
+ * @brief Set up an empty batch.
+ *
+ * @param batch the batch.
+ */
+void
+mcp2515_batch_init(mcp2515_batch_t *batch)
+{
+	batch->count = 0;
+}
+
+/**
+ * @brief Queue a read from a register.
+ *
+ * @param batch the batch.
+ * @param data the destination to copy the read data to.
+ * @param len the length of the destination buffer.
+ * @param rgstr the register to read.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_register_read(mcp2515_batch_t *batch, uint8_t *data, uint8_t len, const mcp2515_rgstr_t rgstr)
+{
+	struct mcp2515_batch_op *op;
+	int res = -1;
+
+	if ((size_t)rgstr + len > PI_MCP2515_REGISTER_SPACE_LEN)
+		goto err;
+	if ((op = batch_op_add(batch, PI_MCP2515_INSTR_READ)) == NULL)
+		goto err;
+
+	op->cmd[op->cmd_len++] = (uint8_t)rgstr;
+	op->rx = data;
+	op->data_len = len;
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Queue a write to a register.
+ *
+ * @param batch the batch.
+ * @param values the data to write to the register.
+ * @param len the length of the data to write.
+ * @param rgstr the register to write to.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_register_write(mcp2515_batch_t *batch, const uint8_t *values, uint8_t len, const mcp2515_rgstr_t rgstr)
+{
+	struct mcp2515_batch_op *op;
+	int res = -1;
+
+	if ((size_t)rgstr + len > PI_MCP2515_REGISTER_SPACE_LEN)
+		goto err;
+	if ((op = batch_op_add(batch, PI_MCP2515_INSTR_WRITE)) == NULL)
+		goto err;
+
+	op->cmd[op->cmd_len++] = (uint8_t)rgstr;
+	op->tx = values;
+	op->data_len = len;
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Queue a bit modify of a register.
+ *
+ * @param batch the batch.
+ * @param data the data to use for the bitmod.
+ * @param mask the mask to apply where only bits with a 1 value will be updated in the register with the data values.
+ * @param rgstr the register to modify.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_register_bitmod(mcp2515_batch_t *batch, uint8_t data, uint8_t mask, const mcp2515_rgstr_t rgstr)
+{
+	struct mcp2515_batch_op *op;
+	int res = -1;
+
+	if ((op = batch_op_add(batch, PI_MCP2515_INSTR_BITMOD)) == NULL)
+		goto err;
+
+	op->cmd[op->cmd_len++] = (uint8_t)rgstr;
+	op->cmd[op->cmd_len++] = mask;
+	op->cmd[op->cmd_len++] = data;
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Queue a read of the MCP2515 status, as returned by mcp2515_status.
+ *
+ * @param batch the batch.
+ * @param status the destination to copy the status to.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_status(mcp2515_batch_t *batch, uint8_t *status)
+{
+	struct mcp2515_batch_op *op;
+	int res = -1;
+
+	if ((op = batch_op_add(batch, PI_MCP2515_INSTR_READ_STATUS)) == NULL)
+		goto err;
+
+	op->rx = status;
+	op->data_len = 1;
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Queue loading a CAN bus frame into a TX buffer.
+ *
+ * The frame is copied into the batch, so it need not remain valid until the flush. Nothing is sent until a request to
+ * send is made for the buffer (see mcp2515_batch_rts).
+ *
+ * @param batch the batch.
+ * @param buffer the TX buffer to load (0-2).
+ * @param can_frame the CAN bus frame to load.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_load_tx(mcp2515_batch_t *batch, uint8_t buffer, const pi_mcp2515_can_frame_t *can_frame)
+{
+	static const uint8_t instrs[] = {
+		PI_MCP2515_INSTR_LOAD_TX0, PI_MCP2515_INSTR_LOAD_TX1, PI_MCP2515_INSTR_LOAD_TX2
+	};
+	struct mcp2515_batch_op *op;
+	int res = -1;
+
+	if (buffer >= sizeof(instrs))
+		goto err;
+	if ((op = batch_op_add(batch, instrs[buffer])) == NULL)
+		goto err;
+
+	op->cmd_len += mcp2515_can_frame_encode(can_frame, &op->cmd[1]);
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Queue a request to send for one or more TX buffers.
+ *
+ * @param batch the batch.
+ * @param buffers a bitmask of the TX buffers to send, with bit 0 for TXB0 and so on.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_rts(mcp2515_batch_t *batch, uint8_t buffers)
+{
+	int res = -1;
+
+	if (buffers == 0 || buffers > 0x07)
+		goto err;
+	if (batch_op_add(batch, PI_MCP2515_INSTR_RTS | buffers) == NULL)
+		goto err;
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Carry out all the operations in a batch, in the order they were queued.
+ *
+ * The batch is emptied afterward, whether or not this succeeds, and may be reused.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param batch the batch.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_batch_flush(pi_mcp2515_t *pi_mcp2515, mcp2515_batch_t *batch)
+{
+	pi_mcp2515_spi_seg_t segs[PI_MCP2515_BATCH_MAX * 2];
+	struct mcp2515_batch_op *op;
+	int res = 0;
+	uint8_t i, n = 0;
+
+	if (batch->count == 0)
+		goto end;
+
+	memset(segs, 0, sizeof(segs));
+	for (i = 0; i < batch->count; i++) {
+		op = &batch->ops[i];
+
+		segs[n].tx = op->cmd;
+		segs[n++].len = op->cmd_len;
+		if (op->data_len > 0) {
+			segs[n].tx = op->tx;
+			segs[n].rx = op->rx;
+			segs[n++].len = op->data_len;
+		}
+		segs[n - 1].cs_change = true;
+	}
+
+	if ((res = mcp2515_spi_transfer(pi_mcp2515, segs, n)))
+		goto end;
+
+	for (i = 0; i < batch->count; i++) {
+		op = &batch->ops[i];
+		if (op->cmd[0] == PI_MCP2515_INSTR_READ) {
+			mcp2515_shadow_update(pi_mcp2515, PI_MCP2515_INSTR_READ, op->rx, op->data_len, op->cmd[1]);
+		} else if (op->cmd[0] == PI_MCP2515_INSTR_WRITE) {
+			mcp2515_shadow_update(pi_mcp2515, PI_MCP2515_INSTR_WRITE, op->tx, op->data_len, op->cmd[1]);
+			mcp2515_stats_eflg_write(pi_mcp2515, op->tx, op->data_len, op->cmd[1]);
+		} else if (op->cmd[0] == PI_MCP2515_INSTR_BITMOD) {
+			mcp2515_shadow_bitmod(pi_mcp2515, op->cmd[3], op->cmd[2], op->cmd[1]);
+			if (op->cmd[1] == PI_MCP2515_RGSTR_EFLG)
+				mcp2515_stats_eflg_clear(pi_mcp2515, op->cmd[2] & ~op->cmd[3]);
+		} else if (op->cmd[0] == PI_MCP2515_INSTR_LOAD_TX0 || op->cmd[0] == PI_MCP2515_INSTR_LOAD_TX1
+		    || op->cmd[0] == PI_MCP2515_INSTR_LOAD_TX2) {
+			/* Nothing collects the completion of a batch's sends, so they are counted as they are loaded. */
+			MCP2515_STAT_ADD(pi_mcp2515, frames_tx, 1);
+		}
+	}
+
+end:
+	batch->count = 0;
+
+	return (res);
+}
+/** @} */
@@ -20,13 +20,23 @@
 
 #include "internal.h"
 
-static const uint8_t tx_reg_list[][3] = {
-	/* CTRL, INSTR, TBxIF CANINTF flag */
-	{ PI_MCP2515_RGSTR_TXB0CTRL, PI_MCP2515_INSTR_LOAD_TX0, PI_MCP2515_CANINTF_TX0IF },
-	{ PI_MCP2515_RGSTR_TXB1CTRL, PI_MCP2515_INSTR_LOAD_TX1, PI_MCP2515_CANINTF_TX1IF },
-	{ PI_MCP2515_RGSTR_TXB2CTRL, PI_MCP2515_INSTR_LOAD_TX2, PI_MCP2515_CANINTF_TX2IF }
+static const uint8_t tx_reg_list[][4] = {
+	/* CTRL, INSTR, TBxIF CANINTF flag, RTS INSTR */
+	{ PI_MCP2515_RGSTR_TXB0CTRL, PI_MCP2515_INSTR_LOAD_TX0, PI_MCP2515_CANINTF_TX0IF, PI_MCP2515_INSTR_RTS_TX0 },
+	{ PI_MCP2515_RGSTR_TXB1CTRL, PI_MCP2515_INSTR_LOAD_TX1, PI_MCP2515_CANINTF_TX1IF, PI_MCP2515_INSTR_RTS_TX1 },
+	{ PI_MCP2515_RGSTR_TXB2CTRL, PI_MCP2515_INSTR_LOAD_TX2, PI_MCP2515_CANINTF_TX2IF, PI_MCP2515_INSTR_RTS_TX2 }
 };
 
+static int	can_read_rxb_raw(pi_mcp2515_t *, mcp2515_rxb_t, uint8_t, uint8_t *);
+static int	can_read_rxb(pi_mcp2515_t *, mcp2515_rxb_t, uint8_t, pi_mcp2515_can_frame_t *);
+static void	can_rx_observe(pi_mcp2515_t *, uint8_t);
+static int	can_message_read_rx(pi_mcp2515_t *, pi_mcp2515_can_rx_frame_t *, bool);
+static int	can_tx_load(pi_mcp2515_t *, const uint8_t *, uint8_t *);
+static uint64_t	can_frame_time(pi_mcp2515_t *, const uint8_t *);
+static uint8_t	can_tx_wait(pi_mcp2515_t *, uint8_t, uint64_t);
+static int	can_send(pi_mcp2515_t *, const uint8_t *);
+static int	can_send_async(pi_mcp2515_t *, const uint8_t *, uint8_t *);
+
 /**
  * @brief Assemble a CAN bus message frame ID.
  *
@@ -37,6 +47,7 @@ static const uint8_t tx_reg_list[][3] = {
 uint32_t
 mcp2515_can_id_build(uint32_t id, const bool extended_id)
 {
+	uint32_t res;
 	uint16_t id_tmp = 0;
 	uint8_t result[4] = {0};
 
@@ -56,7 +67,446 @@ mcp2515_can_id_build(uint32_t id, const bool extended_id)
 		result[0] = (uint8_t)(id_tmp >> 3);
 	}
 
-	return (*((uint32_t *)result));
+	memcpy(&res, result, sizeof(res));
+
+	return (res);
+}
+
+/*! @cond DOXYGEN_IGNORE */
+/**
+ * @brief Decode a CAN bus frame from the bytes of an RX buffer, from SIDH through to D7.
+ *
+ * @param buffer the RX buffer contents, MCP2515_FRAME_LEN bytes as read by a READ RX BUFFER instruction.
+ * @param can_frame a pointer to the structure to store the decoded CAN bus frame.
+ */
+void
+mcp2515_can_frame_decode(const uint8_t *buffer, pi_mcp2515_can_frame_t *can_frame)
+{
+	uint32_t id;
+
+	id = ((uint32_t)buffer[0] << 3) | (buffer[1] >> 5);
+	can_frame->extended_id = !!(buffer[1] & PI_MCP2515_RXBSIDL_IDE);
+	if (can_frame->extended_id) {
+		id = (id << 18) | ((uint32_t)(buffer[1] & 0x03) << 16) | ((uint32_t)buffer[2] << 8) | buffer[3];
+		/* Extended remote frames are flagged in the DLC register, but standard ones are flagged by SRR. */
+		can_frame->rtr = !!(buffer[4] & PI_MCP2515_CAN_DLC_RTR_FLAG);
+	} else
+		can_frame->rtr = !!(buffer[1] & PI_MCP2515_RXBSIDL_SRR);
+	can_frame->id = id;
+
+	/* A DLC above 8 is valid on the bus, but still means 8 bytes of payload. */
+	can_frame->dlc = buffer[4] & PI_MCP2515_CAN_DLC_RTR_MASK;
+	if (can_frame->dlc > PI_MCP2515_CAN_FRAME_PAYLOAD_MAX)
+		can_frame->dlc = PI_MCP2515_CAN_FRAME_PAYLOAD_MAX;
+	if (!can_frame->rtr)
+		memcpy(can_frame->payload, &buffer[5], can_frame->dlc);
+}
+/*! @endcond */
+
+/**
+ * @brief Read an RX buffer, using what the RX status says about it to read no more than needed.
+ *
+ * Everything needed, including IDE and SRR in SIDL, comes out of the one READ RX BUFFER burst.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rxb the RX buffer to read.
+ * @param rx_status the RX status, which must describe @p rxb.
+ * @param buffer where to put the RX buffer contents, MCP2515_FRAME_LEN bytes from SIDH through to D7. The payload is
+ * left as it is for remote frames.
+ * @return zero if success, otherwise non-zero.
+ */
+static int
+can_read_rxb_raw(pi_mcp2515_t *pi_mcp2515, mcp2515_rxb_t rxb, uint8_t rx_status, uint8_t *buffer)
+{
+	uint8_t instr;
+	pi_mcp2515_spi_seg_t segs[2] = {
+		{ .tx = &instr, .len = 1 },
+		{ .rx = buffer, .len = MCP2515_FRAME_LEN, .cs_change = true },
+	};
+	int res;
+
+	instr = rxb == PI_MCP2515_RXB0 ? PI_MCP2515_INSTR_READ_RX0 : PI_MCP2515_INSTR_READ_RX1;
+
+	/* Remote frames have no payload, so there is no need to read past the DLC. */
+	if (rx_status & PI_MCP2515_RX_STATUS_RTR)
+		segs[1].len = 5;
+
+	/* Whatever fills the RX buffer after this is new to can_rx_observe. */
+	pi_mcp2515->rx_seen[rxb] = 0;
+
+	if ((res = mcp2515_spi_transfer(pi_mcp2515, segs, 2)) == 0) {
+		MCP2515_STAT_ADD(pi_mcp2515, frames_rx, 1);
+		MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_RX, rxb, MCP2515_TRACE_HDR(buffer), buffer[4]);
+	}
+
+	return (res);
+}
+
+/**
+ * @brief Read and decode an RX buffer (see can_read_rxb_raw), unless the software filter discards it.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rxb the RX buffer to read.
+ * @param rx_status the RX status, which must describe @p rxb.
+ * @param can_frame a pointer to the structure to store the received CAN bus frame.
+ * @return zero if success, 1 if the software filter discarded the frame, otherwise -1.
+ */
+static int
+can_read_rxb(pi_mcp2515_t *pi_mcp2515, mcp2515_rxb_t rxb, uint8_t rx_status, pi_mcp2515_can_frame_t *can_frame)
+{
+	uint8_t buffer[MCP2515_FRAME_LEN] = { 0 };
+	int res = -1;
+
+	if (can_read_rxb_raw(pi_mcp2515, rxb, rx_status, buffer))
+		goto end;
+
+	if (!mcp2515_sw_filter_rx(pi_mcp2515, buffer)) {
+		res = 1;
+		goto end;
+	}
+	mcp2515_can_frame_decode(buffer, can_frame);
+	res = 0;
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Note any RX buffers which have filled since they were last checked, with when and in what order.
+ *
+ * INT only falls when an interrupt flag is set while none were, so with RX interrupts enabled, the latest edge up to
+ * now is from the first frame to arrive since. That frame gets the edge's timestamp, and any other gets the time it
+ * was first seen here. Where both RX buffers filled since they were last checked, RXB0 is taken to be first.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rx_status the RX status, just read.
+ */
+static void
+can_rx_observe(pi_mcp2515_t *pi_mcp2515, uint8_t rx_status)
+{
+	uint64_t now = mcp2515_time_nsec(), edge_nsec;
+	mcp2515_rxb_t rxb;
+	bool edge;
+
+	if (pi_mcp2515->int_enabled)
+		mcp2515_gpio_int_drain(pi_mcp2515);
+	edge = mcp2515_int_edge_take(pi_mcp2515, now, &edge_nsec);
+
+	for (rxb = PI_MCP2515_RXB0; rxb <= PI_MCP2515_RXB1; rxb++) {
+		if (!(rx_status & (PI_MCP2515_RX_STATUS_RCV_RXB0 << rxb))) {
+			pi_mcp2515->rx_seen[rxb] = 0;
+			continue;
+		}
+		if (pi_mcp2515->rx_seen[rxb] != 0)
+			continue;
+
+		/* Zero means unseen, so is skipped when the sequence wraps. */
+		if (++pi_mcp2515->rx_seq == 0)
+			pi_mcp2515->rx_seq++;
+		pi_mcp2515->rx_seen[rxb] = pi_mcp2515->rx_seq;
+		pi_mcp2515->rx_stamp[rxb] = edge ? edge_nsec : now;
+		pi_mcp2515->rx_stamp_edge[rxb] = edge;
+		edge = false;
+	}
+}
+
+/**
+ * @brief Read a CAN bus message, with where and when it was received, skipping any the software filter discards.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rx_frame a pointer to the structure to store the received CAN bus frame and where it was received.
+ * @param ordered true to read whichever RX buffer filled first, otherwise RXB0 is read first.
+ * @return zero if success, otherwise non-zero.
+ */
+static int
+can_message_read_rx(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_rx_frame_t *rx_frame, bool ordered)
+{
+	int res;
+	uint8_t rx_status, ctrl;
+	mcp2515_rxb_t rxb;
+
+	do {
+		res = -1;
+		rx_status = mcp2515_rx_status(pi_mcp2515);
+		can_rx_observe(pi_mcp2515, rx_status);
+		if (!(rx_status & PI_MCP2515_RX_STATUS_RCV_ALL))
+			break;
+
+		/* Sequence numbers wrap, so compare them by difference. */
+		rxb = PI_MCP2515_RXB0;
+		if (!(rx_status & PI_MCP2515_RX_STATUS_RCV_RXB0) || (ordered && (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB1)
+		    && (int32_t)(pi_mcp2515->rx_seen[1] - pi_mcp2515->rx_seen[0]) < 0))
+			rxb = PI_MCP2515_RXB1;
+
+		/* The RX status describes RXB0 whenever it is full, so RXB1 is otherwise read in full. */
+		if (rxb == PI_MCP2515_RXB1 && (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB0)) {
+			if (mcp2515_register_read(pi_mcp2515, &ctrl, 1, PI_MCP2515_RGSTR_RXB1CTRL))
+				break;
+			rx_status = PI_MCP2515_RX_STATUS_RCV_RXB1 | (ctrl & PI_MCP2515_RXB1CTRL_FILHIT);
+		}
+
+		if (!(res = can_read_rxb(pi_mcp2515, rxb, rx_status, &rx_frame->frame))) {
+			rx_frame->rxb = rxb;
+			rx_frame->filhit = (mcp2515_rxf_t)PI_MCP2515_RX_STATUS_RXF(rx_status);
+			rx_frame->timestamp = pi_mcp2515->rx_stamp[rxb];
+			rx_frame->timestamp_edge = pi_mcp2515->rx_stamp_edge[rxb];
+		}
+	} while (res == 1);
+
+	return (res);
+}
+
+/**
+ * @brief Prepare the SPI transaction segments to load a CAN bus frame into a TX buffer and request to send it.
+ *
+ * This clears any old TXnIF flag for the TX buffer, sets its priority, loads it, and issues the RTS, as four commands.
+ *
+ * @param load storage for the commands, which must remain valid until the transfer.
+ * @param segs where to put the segments, which must have room for MCP2515_TX_LOAD_SEGS.
+ * @param txb the TX buffer (0-2).
+ * @param txp the transmit priority (0-3), where 3 is the highest.
+ * @param can_frame the CAN bus frame to send.
+ * @return the number of segments used.
+ */
+uint8_t
+mcp2515_can_tx_load_prepare(struct mcp2515_tx_load *load, pi_mcp2515_spi_seg_t *segs, uint8_t txb, uint8_t txp,
+    const pi_mcp2515_can_frame_t *can_frame)
+{
+	mcp2515_can_frame_encode(can_frame, load->payload);
+
+	return (mcp2515_can_tx_load_prepare_wire(load, segs, txb, txp, load->payload));
+}
+
+/**
+ * @brief Prepare the SPI transaction segments to load an encoded CAN bus frame (see mcp2515_can_tx_load_prepare).
+ *
+ * The frame is loaded straight from @p regs, without copying it.
+ *
+ * @param load storage for the commands, which must remain valid until the transfer.
+ * @param segs where to put the segments, which must have room for MCP2515_TX_LOAD_SEGS.
+ * @param txb the TX buffer (0-2).
+ * @param txp the transmit priority (0-3), where 3 is the highest.
+ * @param regs the frame as laid out in the TX buffer registers, which must remain valid until the transfer.
+ * @return the number of segments used.
+ */
+uint8_t
+mcp2515_can_tx_load_prepare_wire(struct mcp2515_tx_load *load, pi_mcp2515_spi_seg_t *segs, uint8_t txb, uint8_t txp,
+    const uint8_t *regs)
+{
+	load->clear[0] = PI_MCP2515_INSTR_BITMOD;
+	load->clear[1] = PI_MCP2515_RGSTR_CANINTF;
+	load->clear[2] = tx_reg_list[txb][2];
+	load->clear[3] = 0;
+	load->txp[0] = PI_MCP2515_INSTR_BITMOD;
+	load->txp[1] = tx_reg_list[txb][0];
+	load->txp[2] = PI_MCP2515_CTRL_TXP_MASK;
+	load->txp[3] = txp & PI_MCP2515_CTRL_TXP_MASK;
+	load->instr = tx_reg_list[txb][1];
+	load->rts = tx_reg_list[txb][3];
+
+	memset(segs, 0, MCP2515_TX_LOAD_SEGS * sizeof(pi_mcp2515_spi_seg_t));
+	segs[0].tx = load->clear;
+	segs[0].len = sizeof(load->clear);
+	segs[0].cs_change = true;
+	segs[1].tx = load->txp;
+	segs[1].len = sizeof(load->txp);
+	segs[1].cs_change = true;
+	segs[2].tx = &load->instr;
+	segs[2].len = 1;
+	segs[3].tx = regs;
+	segs[3].len = mcp2515_wire_frame_len(regs);
+	segs[3].cs_change = true;
+	segs[4].tx = &load->rts;
+	segs[4].len = 1;
+	segs[4].cs_change = true;
+
+	return (MCP2515_TX_LOAD_SEGS);
+}
+
+/**
+ * @brief Load a CAN bus frame into a free TX buffer and request to send it.
+ *
+ * A TX buffer is free if it isn't waiting to send, and it isn't in use by an asynchronous send, the TX queue, or a
+ * mailbox. Finding one takes a single READ STATUS, and the load is then a single SPI transaction.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param regs the frame as laid out in the TX buffer registers.
+ * @param txb set to the TX buffer used.
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1.
+ */
+static int
+can_tx_load(pi_mcp2515_t *pi_mcp2515, const uint8_t *regs, uint8_t *txb)
+{
+	struct mcp2515_tx_load load;
+	pi_mcp2515_spi_seg_t segs[MCP2515_TX_LOAD_SEGS];
+	int res = -1;
+	uint8_t free_txbs, i;
+
+	free_txbs = mcp2515_can_tx_free(pi_mcp2515, mcp2515_status(pi_mcp2515));
+	for (i = 0; i < 3 && !(free_txbs & (1 << i)); i++)
+		;
+	if (i == 3) {
+		MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_BUSY, free_txbs, 1);
+		goto end;
+	}
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_LOAD, i, MCP2515_TRACE_HDR(regs), regs[4]);
+
+	res = mcp2515_spi_transfer(pi_mcp2515, segs, mcp2515_can_tx_load_prepare_wire(&load, segs, i, 0, regs)) ? 1 : 0;
+	*txb = i;
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Work out how long a frame takes to send, from the bit timing configured in the CNF registers.
+ *
+ * Bit stuffing isn't counted, so this is the shortest the frame can take.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param regs the frame as laid out in the TX buffer registers.
+ * @return the time in microseconds, at least 1.
+ */
+static uint64_t
+can_frame_time(pi_mcp2515_t *pi_mcp2515, const uint8_t *regs)
+{
+	uint8_t cnf[3], ps1;
+	uint32_t bits, tqs;
+	uint64_t usec;
+
+	/* CNF3, CNF2 and CNF1, in that order. */
+	if (mcp2515_register_read(pi_mcp2515, cnf, 3, PI_MCP2515_RGSTR_CNF3))
+		return (MCP2515_INT_POLL_USEC);
+
+	/* SOF through DLC, CRC, ACK, EOF and the interframe space, and the 18 bit extended ID with SRR and IDE. */
+	bits = (regs[1] & PI_MCP2515_TXBSIDL_EXIDE) ? 67 : 47;
+	bits += 8 * (mcp2515_wire_frame_len(regs) - 5);
+
+	/* The sync segment, PRSEG, PHSEG1, and PHSEG2, which is the greater of PHSEG1 and 2 Tqs unless BTLMODE is set. */
+	ps1 = ((cnf[1] >> 3) & 0x07) + 1;
+	tqs = 1 + (cnf[1] & 0x07) + 1 + ps1;
+	if (cnf[1] & 0x80)
+		tqs += (cnf[0] & 0x07) + 1;
+	else
+		tqs += ps1 > 2 ? ps1 : 2;
+
+	/* A Tq is 2 * (BRP + 1) oscillator cycles. */
+	usec = mcp2515_osc_time(pi_mcp2515, bits * tqs * 2 * ((cnf[2] & 0x3f) + 1));
+
+	return (usec > 0 ? usec : 1);
+}
+
+/**
+ * @brief Wait on a TX buffer's TXnREQ, which stays set until its message is sent or aborted.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param txb the TX buffer (0-2).
+ * @param poll_usec how long to sleep before each READ STATUS, ideally the time the frame takes to send.
+ * @return the last READ STATUS, which still has TXnREQ set if it timed out.
+ */
+static uint8_t
+can_tx_wait(pi_mcp2515_t *pi_mcp2515, uint8_t txb, uint64_t poll_usec)
+{
+	uint64_t deadline;
+	uint8_t status;
+
+	deadline = mcp2515_time_usec() + MCP2515_TX_TIMEOUT_USEC;
+	do {
+		mcp2515_micro_sleep(poll_usec);
+		status = mcp2515_status(pi_mcp2515);
+	} while ((status & (PI_MCP2515_STATUS_TX0REQ << (txb * 2))) && mcp2515_time_usec() < deadline);
+
+	return (status);
+}
+
+/**
+ * @brief Send a CAN bus message, waiting until it has been sent.
+ *
+ * If the message isn't sent in time, it is aborted, so it can't still go out after failure has been reported.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param regs the frame as laid out in the TX buffer registers.
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1 if the message failed to send.
+ */
+static int
+can_send(pi_mcp2515_t *pi_mcp2515, const uint8_t *regs)
+{
+	int res;
+	uint64_t poll_usec;
+	uint8_t status, ctrl = 0, i;
+
+	if ((res = can_tx_load(pi_mcp2515, regs, &i)))
+		goto end;
+
+	poll_usec = can_frame_time(pi_mcp2515, regs);
+	status = can_tx_wait(pi_mcp2515, i, poll_usec);
+
+	/*
+	 * Otherwise the MCP2515 carries on retrying. A message already on the bus isn't stopped by aborting, so wait for
+	 * TXnREQ to drop again, after which it may turn out to have been sent after all.
+	 */
+	if (status & (PI_MCP2515_STATUS_TX0REQ << (i * 2))) {
+		mcp2515_register_bitmod(pi_mcp2515, 0, PI_MCP2515_CTRL_TXREQ, tx_reg_list[i][0]);
+		status = can_tx_wait(pi_mcp2515, i, poll_usec);
+	}
+
+	if ((status & (PI_MCP2515_STATUS_TX0IF << (i * 2))) == 0) {
+		mcp2515_register_read(pi_mcp2515, &ctrl, 1, tx_reg_list[i][0]);
+		MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_FAIL, i, ctrl);
+		if (ctrl & (PI_MCP2515_CTRL_TXERR | PI_MCP2515_CTRL_MLOA | PI_MCP2515_CTRL_ABTF))
+			MCP2515_STAT_ADD(pi_mcp2515, tx_errors, 1);
+		res = 1;
+		goto end;
+	}
+	MCP2515_STAT_ADD(pi_mcp2515, frames_tx, 1);
+	mcp2515_can_clear_txif(pi_mcp2515, i);
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Start sending a CAN bus message, keeping its TX buffer until mcp2515_can_tx_poll collects it.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param regs the frame as laid out in the TX buffer registers.
+ * @param txb if not NULL, set to the TX buffer used (0-2).
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1.
+ */
+static int
+can_send_async(pi_mcp2515_t *pi_mcp2515, const uint8_t *regs, uint8_t *txb)
+{
+	int res;
+	uint8_t i;
+
+	if ((res = can_tx_load(pi_mcp2515, regs, &i)))
+		goto end;
+
+	pi_mcp2515->tx_pending |= 1 << i;
+	if (txb != NULL)
+		*txb = i;
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Find the TX buffers which are free to load.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param status the result of a READ STATUS.
+ * @return the free TX buffers, with bit 0 for TXB0 and so on.
+ */
+uint8_t
+mcp2515_can_tx_free(const pi_mcp2515_t *pi_mcp2515, uint8_t status)
+{
+	uint8_t res = 0, i;
+
+	for (i = 0; i < 3; i++)
+		if (!(status & (PI_MCP2515_STATUS_TX0REQ << (i * 2))))
+			res |= 1 << i;
+
+	return (res & ~(pi_mcp2515->tx_pending | pi_mcp2515->tx_queued | pi_mcp2515->tx_mailbox));
 }
 
 /**
@@ -88,10 +538,8 @@ mcp2515_can_clear_txif(pi_mcp2515_t *pi_mcp2515, const uint8_t index)
 		res = -1;
 		goto end;
 	}
-	MCP2515_DEBUG(pi_mcp2515, "clearing TX%dIF\n", index);
-	CS_LOW(pi_mcp2515);
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_CLEAR, index);
 	res = mcp2515_register_bitmod(pi_mcp2515, 0, flag, PI_MCP2515_RGSTR_CANINTF);
-	CS_HIGH(pi_mcp2515);
 end:
 	return (res);
 }
@@ -102,71 +550,247 @@ end:
  * @{
  */
 /**
- * @brief Send a CAN bus message.
+ * @brief Send a CAN bus message, waiting until it has been sent.
+ *
+ * If the message isn't sent in time, such as when nothing acknowledges it, the send is aborted before returning, so it
+ * is safe to retry without the message going out twice.
  *
  * @param pi_mcp2515 the piMCP2515 handle.
  * @param can_frame the CAN bus frame to send.
- * @return zero if success, otherwise non-zero.
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1 if the message failed to send.
  */
 int
 mcp2515_can_message_send(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_can_frame_t *can_frame)
 {
-	int res;
-	uint32_t built_id;
-	uint8_t payload[13], ctrl = 0, instr = 0, canintf = 0, i;
+	pi_mcp2515_wire_frame_t wire_frame;
 
-	res = -1;
+	mcp2515_wire_frame_encode(can_frame, &wire_frame);
 
-	for (i = 0; i < (uint8_t)(sizeof(tx_reg_list) / sizeof(tx_reg_list[0])); i++) {
-		mcp2515_register_read(pi_mcp2515, &ctrl, 1, tx_reg_list[i][0]);
-		MCP2515_DEBUG(pi_mcp2515, "checking tx_reg_list[%d] CTRL: 0x%02x\n", ctrl);
-		if ((ctrl & PI_MCP2515_CTRL_TXREQ) == 0) {
-			MCP2515_DEBUG(pi_mcp2515, "Using tx_reg_list[%d]\n", i);
+	return (can_send(pi_mcp2515, wire_frame.regs));
+}
+
+/**
+ * @brief Send an encoded CAN bus message (see mcp2515_wire_frame_encode), waiting until it has been sent.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param wire_frame the CAN bus frame to send.
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1 if the message failed to send.
+ */
+int
+mcp2515_can_wire_send(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_wire_frame_t *wire_frame)
+{
+	return (can_send(pi_mcp2515, wire_frame->regs));
+}
 
-			built_id = mcp2515_can_id_build(can_frame->id, can_frame->extended_id);
-			*((uint32_t *)payload) = built_id;
+/**
+ * @brief Start sending a CAN bus message, without waiting for it to be sent.
+ *
+ * This returns as soon as the message is loaded into a TX buffer and requested to send. The TX buffer is then kept
+ * until its completion has been collected with mcp2515_can_tx_poll. To be notified of completion rather than polling,
+ * enable the TXnIE interrupts (see mcp2515_interrupts_enable and mcp2515_int_wait).
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param can_frame the CAN bus frame to send.
+ * @param txb if not NULL, set to the TX buffer used (0-2).
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1.
+ */
+int
+mcp2515_can_message_send_async(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_can_frame_t *can_frame, uint8_t *txb)
+{
+	pi_mcp2515_wire_frame_t wire_frame;
 
-			payload[4] = can_frame->rtr ? (can_frame->dlc | PI_MCP2515_CAN_DLC_RTR_FLAG) : can_frame->dlc;
-			if (!can_frame->rtr)
-				memcpy(&payload[5], can_frame->payload, can_frame->dlc);
+	mcp2515_wire_frame_encode(can_frame, &wire_frame);
 
-			instr = tx_reg_list[i][1];
-			CS_LOW(pi_mcp2515);
-			mcp2515_gpio_spi_write_blocking(pi_mcp2515, &instr, 1);
-			mcp2515_gpio_spi_write_blocking(pi_mcp2515, payload, can_frame->rtr ? 5 : (can_frame->dlc + 5));
-			CS_HIGH(pi_mcp2515);
+	return (can_send_async(pi_mcp2515, wire_frame.regs, txb));
+}
 
-			res = 0;
-			break;
+/**
+ * @brief Start sending an encoded CAN bus message, without waiting for it to be sent (see
+ * mcp2515_can_message_send_async).
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param wire_frame the CAN bus frame to send.
+ * @param txb if not NULL, set to the TX buffer used (0-2).
+ * @return zero if success, -1 if no TX buffer was available, otherwise 1.
+ */
+int
+mcp2515_can_wire_send_async(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_wire_frame_t *wire_frame, uint8_t *txb)
+{
+	return (can_send_async(pi_mcp2515, wire_frame->regs, txb));
+}
+
+/**
+ * @brief Start sending up to three CAN bus messages back to back, without waiting for them to be sent.
+ *
+ * The messages are loaded into free TX buffers and all requested to send with a single RTS, in one SPI transaction
+ * after one READ STATUS. Each is given a lower priority than the one before, so they go out in the order given. As with
+ * mcp2515_can_message_send_async, the TX buffers are kept until their completion has been collected with
+ * mcp2515_can_tx_poll.
+ *
+ * Nothing is sent unless there are enough free TX buffers for every message.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param can_frames the CAN bus frames to send.
+ * @param n how many frames to send (1-3).
+ * @param txbs if not NULL, set to the TX buffers used, with bit 0 for TXB0 and so on.
+ * @return zero if success, -1 if not enough TX buffers were available, otherwise 1.
+ */
+int
+mcp2515_can_message_send_burst(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_can_frame_t *can_frames, uint8_t n,
+    uint8_t *txbs)
+{
+	struct mcp2515_tx_load loads[3];
+	/* Each load leaves off its own RTS, which the next load or the combined RTS takes the place of. */
+	pi_mcp2515_spi_seg_t segs[3 * MCP2515_TX_LOAD_SEGS];
+	int res = -1;
+	uint8_t free_txbs, used = 0, rts = PI_MCP2515_INSTR_RTS, seg_n = 0, i, j;
+
+	if (n == 0 || n > 3)
+		goto end;
+
+	free_txbs = mcp2515_can_tx_free(pi_mcp2515, mcp2515_status(pi_mcp2515));
+	for (i = 0, j = 0; i < n; i++, j++) {
+		for (; j < 3 && !(free_txbs & (1 << j)); j++)
+			;
+		if (j == 3) {
+			MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_BUSY, free_txbs, n);
+			goto end;
 		}
+		seg_n += mcp2515_can_tx_load_prepare(&loads[i], &segs[seg_n], j, 3 - i, &can_frames[i]) - 1;
+		MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_LOAD, j, MCP2515_TRACE_HDR(loads[i].payload),
+		    loads[i].payload[4]);
+		used |= 1 << j;
+	}
+
+	rts |= used;
+	memset(&segs[seg_n], 0, sizeof(segs[seg_n]));
+	segs[seg_n].tx = &rts;
+	segs[seg_n].len = 1;
+	segs[seg_n++].cs_change = true;
+
+	if ((res = mcp2515_spi_transfer(pi_mcp2515, segs, seg_n) ? 1 : 0))
+		goto end;
+
+	pi_mcp2515->tx_pending |= used;
+	if (txbs != NULL)
+		*txbs = used;
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Collect the completion of messages started with mcp2515_can_message_send_async.
+ *
+ * A message is complete once the MCP2515 has either sent it, or the send has been aborted. This takes a single SPI
+ * transaction to check, plus one to clear the TXnIF flags if anything was sent. Those TX buffers are then free again.
+ *
+ * Messages which are still pending may be retrying after errors. With @p errors, the error bits of those and of any
+ * aborted messages are read from TXBnCTRL too, which takes one more SPI transaction. A message which never gets sent,
+ * such as when nothing on the bus acknowledges it, stays pending until aborted with mcp2515_can_tx_abort.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param sent if not NULL, set to the TX buffers whose message was sent, with bit 0 for TXB0 and so on.
+ * @param failed if not NULL, set to the TX buffers whose message was aborted, as for @p sent.
+ * @param errors if not NULL, an array of three, set to the TXERR, MLOA, and ABTF bits (PI_MCP2515_CTRL_*) of each TX
+ *               buffer whose message was aborted or is still pending, otherwise zero.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_can_tx_poll(pi_mcp2515_t *pi_mcp2515, uint8_t *sent, uint8_t *failed, uint8_t *errors)
+{
+	pi_mcp2515_spi_seg_t segs[6];
+	int res = 0;
+	uint8_t cmds[3][2], ctrl[3] = { 0 }, status, done = 0, aborted = 0, seg_n = 0, i;
+
+	if (pi_mcp2515->tx_pending == 0)
+		goto end;
+
+	status = mcp2515_status(pi_mcp2515);
+	for (i = 0; i < 3; i++) {
+		if (!(pi_mcp2515->tx_pending & (1 << i)) || (status & (PI_MCP2515_STATUS_TX0REQ << (i * 2))))
+			continue;
+		/* TXnIF is only set when the message was actually sent. */
+		if (status & (PI_MCP2515_STATUS_TX0IF << (i * 2)))
+			done |= 1 << i;
+		else
+			aborted |= 1 << i;
 	}
-	if (res != -1) {
-		mcp2515_rts(pi_mcp2515, i);
-
-		/* TODO Determine if/how much delay is needed in all scenarios (ex. 500 vs 1000 CAN speed)
-		 *
-		 * At 500kbps CAN speed w/8Mhz osc, and 10_000_000 SPI clock, 500 is not long enough.
-		 */
-		/* Sleep to ensure send is complete and to check TXxIF is set after send if all is well.
-		 */
-		mcp2515_micro_sleep(750);
-
-		/* Check status again for errors */
-		mcp2515_register_read(pi_mcp2515, &ctrl, 1, tx_reg_list[i][0]);
-		if (ctrl & (PI_MCP2515_CTRL_TXERR | PI_MCP2515_CTRL_MLOA | PI_MCP2515_CTRL_ABTF)) {
-			MCP2515_DEBUG(pi_mcp2515, "TX%dCTRL has errors. Value: 0x%02x\n", ctrl);
-			res = 1;
-		}
 
-		mcp2515_register_read(pi_mcp2515, &canintf, 1, PI_MCP2515_RGSTR_CANINTF);
-		if ((canintf & tx_reg_list[i][2]) == 0) {
-			res = 1;
-			MCP2515_DEBUG(pi_mcp2515, "TXxIF not set after sending.\n");
+	/* Before the aborted TX buffers are given up, and could be loaded again. */
+	if (errors != NULL) {
+		memset(segs, 0, sizeof(segs));
+		for (i = 0; i < 3; i++) {
+			if (!(pi_mcp2515->tx_pending & ~done & (1 << i)))
+				continue;
+			cmds[i][0] = PI_MCP2515_INSTR_READ;
+			cmds[i][1] = tx_reg_list[i][0];
+			segs[seg_n].tx = cmds[i];
+			segs[seg_n++].len = sizeof(cmds[i]);
+			segs[seg_n].rx = &ctrl[i];
+			segs[seg_n].len = 1;
+			segs[seg_n++].cs_change = true;
+		}
+		if (seg_n > 0 && (res = mcp2515_spi_transfer(pi_mcp2515, segs, seg_n))) {
+			done = aborted = 0;
 			goto end;
 		}
-		mcp2515_can_clear_txif(pi_mcp2515, i);
-	} else
-		MCP2515_DEBUG(pi_mcp2515, "no available tx found\n");
+	}
+
+	if (done) {
+		res = mcp2515_register_bitmod(pi_mcp2515, 0, done << 2, PI_MCP2515_RGSTR_CANINTF);
+		MCP2515_STAT_ADD(pi_mcp2515, frames_tx, __builtin_popcount(done));
+	}
+	if (aborted)
+		MCP2515_STAT_ADD(pi_mcp2515, tx_errors, __builtin_popcount(aborted));
+	pi_mcp2515->tx_pending &= ~(done | aborted);
+
+end:
+	if (sent != NULL)
+		*sent = done;
+	if (failed != NULL)
+		*failed = aborted;
+	if (errors != NULL) {
+		for (i = 0; i < 3; i++)
+			errors[i] = ctrl[i] & (PI_MCP2515_CTRL_TXERR | PI_MCP2515_CTRL_MLOA | PI_MCP2515_CTRL_ABTF);
+	}
+
+	return (res);
+}
+
+/**
+ * @brief Abort messages started with mcp2515_can_message_send_async.
+ *
+ * A message already on the bus still finishes, and may yet be sent. Either way, the next mcp2515_can_tx_poll collects
+ * it, as sent or aborted, once the MCP2515 is done with it.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param txbs the TX buffers to abort, with bit 0 for TXB0 and so on, which must all have a message pending.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_can_tx_abort(pi_mcp2515_t *pi_mcp2515, uint8_t txbs)
+{
+	pi_mcp2515_spi_seg_t segs[3];
+	int res = -1;
+	uint8_t cmds[3][4], seg_n = 0, i;
+
+	if (txbs == 0 || (txbs & ~pi_mcp2515->tx_pending))
+		goto end;
+
+	memset(segs, 0, sizeof(segs));
+	for (i = 0; i < 3; i++) {
+		if (!(txbs & (1 << i)))
+			continue;
+		cmds[i][0] = PI_MCP2515_INSTR_BITMOD;
+		cmds[i][1] = tx_reg_list[i][0];
+		cmds[i][2] = PI_MCP2515_CTRL_TXREQ;
+		cmds[i][3] = 0;
+		segs[seg_n].tx = cmds[i];
+		segs[seg_n].len = sizeof(cmds[i]);
+		segs[seg_n++].cs_change = true;
+	}
+	res = mcp2515_spi_transfer(pi_mcp2515, segs, seg_n);
 
 end:
 	return (res);
@@ -175,6 +799,8 @@ end:
 /**
  * @brief Read a CAN bus message.
  *
+ * Messages the software filter discards are skipped over.
+ *
  * @param pi_mcp2515 the piMCP2515 handle.
  * @param can_frame a pointer to the structure to store the received CAN bus frame.
  * @return zero if success, otherwise non-zero.
@@ -182,68 +808,224 @@ end:
 int
 mcp2515_can_message_read(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_frame_t *can_frame)
 {
-	int res = -1;
-	uint8_t status;
+	int res;
+	uint8_t rx_status;
 
-	status = mcp2515_status(pi_mcp2515);
-	if (status & PI_MCP2515_STATUS_RX0BF)
-		res = mcp2515_can_message_read_rxb(pi_mcp2515, PI_MCP2515_RXB0, can_frame);
-	else if (status & PI_MCP2515_STATUS_RX1BF)
-		res = mcp2515_can_message_read_rxb(pi_mcp2515, PI_MCP2515_RXB1, can_frame);
+	do {
+		res = -1;
+		rx_status = mcp2515_rx_status(pi_mcp2515);
+		if (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB0)
+			res = can_read_rxb(pi_mcp2515, PI_MCP2515_RXB0, rx_status, can_frame);
+		else if (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB1)
+			res = can_read_rxb(pi_mcp2515, PI_MCP2515_RXB1, rx_status, can_frame);
+	} while (res == 1);
 
 	return (res);
 }
 
+/**
+ * @brief Read a CAN bus message, along with the RX buffer it was received into, the filter it matched, and when it
+ * was received.
+ *
+ * This costs no more SPI traffic than mcp2515_can_message_read, as the RX status it checks first has the RX buffer and
+ * filter. With the INT pin set up by mcp2515_int_init on Linux, the timestamp is the kernel's for the INT edge the
+ * frame caused, if it caused one, which leaves out SPI and scheduling delays. For that, only the RX interrupts should
+ * be enabled. Otherwise, it is when this, or mcp2515_can_message_read_ordered, first saw the frame.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rx_frame a pointer to the structure to store the received CAN bus frame and where it was received.
+ * @return zero if success, otherwise non-zero.
+ */
 int
-mcp2515_can_message_read_rxb(pi_mcp2515_t *pi_mcp2515, mcp2515_rxb_t rxb, pi_mcp2515_can_frame_t *can_frame)
+mcp2515_can_message_read_rx(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_rx_frame_t *rx_frame)
 {
-	uint32_t id;
-	int res;
-	uint8_t buffer[5], status, dlc, instr, reg;
+	return (can_message_read_rx(pi_mcp2515, rx_frame, false));
+}
 
-	res = 0;
+/**
+ * @brief Read a CAN bus message, taking the RX buffers in the order the messages arrived in.
+ *
+ * mcp2515_can_message_read always takes RXB0 first when both RX buffers are full, which can deliver messages out of
+ * order. Instead, this remembers when it first saw each RX buffer full, and takes whichever was seen first. Where both
+ * filled since the last check, RXB0 is taken first. That is always right if RXB1 only receives messages rolled over
+ * from RXB0 (see mcp2515_filter_rollover), as a message only rolls over while RXB0 is full. Otherwise, it can only be
+ * wrong for messages arriving closer together than the calls to this.
+ *
+ * The frame is timestamped as by mcp2515_can_message_read_rx. Messages the software filter discards are skipped over.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rx_frame a pointer to the structure to store the received CAN bus frame and where it was received.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_can_message_read_ordered(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_rx_frame_t *rx_frame)
+{
+	return (can_message_read_rx(pi_mcp2515, rx_frame, true));
+}
 
-	switch (rxb) {
-	case PI_MCP2515_RXB0:
-		reg = PI_MCP2515_RGSTR_RXB0SIDL;
-		instr = PI_MCP2515_INSTR_READ_RX0;
-		break;
-	case PI_MCP2515_RXB1:
-		reg = PI_MCP2515_RGSTR_RXB1SIDL;
-		instr = PI_MCP2515_INSTR_READ_RX1;
-		break;
-	default:
+/**
+ * @brief Read a CAN bus message as a wire frame, ready to send on again without encoding it.
+ *
+ * The payload of a remote frame is zeroed. Messages the software filter discards are skipped over.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param wire_frame a pointer to the structure to store the received CAN bus frame.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_can_message_read_wire(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_wire_frame_t *wire_frame)
+{
+	int res;
+	uint8_t rx_status;
+
+	do {
 		res = -1;
-		goto end;
-	}
-	mcp2515_register_read(pi_mcp2515, &status, 1, reg);
+		rx_status = mcp2515_rx_status(pi_mcp2515);
+		if (!(rx_status & (PI_MCP2515_RX_STATUS_RCV_RXB0 | PI_MCP2515_RX_STATUS_RCV_RXB1)))
+			goto end;
 
-	CS_LOW(pi_mcp2515);
-	mcp2515_gpio_spi_write_blocking(pi_mcp2515, &instr, 1);
-	mcp2515_gpio_spi_read_blocking(pi_mcp2515, buffer, 5);
+		memset(wire_frame, 0, sizeof(*wire_frame));
+		if ((res = can_read_rxb_raw(pi_mcp2515, (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB0) ? PI_MCP2515_RXB0
+		    : PI_MCP2515_RXB1, rx_status, wire_frame->regs)))
+			goto end;
+	} while (!mcp2515_sw_filter_rx(pi_mcp2515, wire_frame->regs));
+	mcp2515_wire_frame_from_rx(wire_frame->regs);
 
-	id = ((uint16_t)buffer[0] << 3) | (buffer[1] >> 5);
-	if (status & PI_MCP2515_RXBSIDL_IDE) {
-		id = (((((id << 2) + (buffer[1] & 0x03)) << 8) + buffer[2]) << 8) + buffer[3];
-		can_frame->extended_id = true;
-	}
-	dlc = buffer[4];
+end:
+	return (res);
+}
 
-	can_frame->id = id;
-	can_frame->dlc = dlc & PI_MCP2515_CAN_DLC_RTR_MASK;
-	can_frame->rtr = !!(dlc & PI_MCP2515_CAN_DLC_RTR_FLAG);
+/**
+ * @brief Read a CAN bus message, but only if it is wanted.
+ *
+ * The RX status is checked first, and passed to @p select to decide from the frame type and filter match (see the
+ * PI_MCP2515_RX_STATUS_* definitions) whether to read the frame. If not, the frame is discarded without reading it.
+ * A frame which is read can still be discarded by the software filter.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param select returns true to read the frame, or false to discard it. It is given the RX status and @p arg.
+ * @param arg an arbitrary pointer passed to @p select.
+ * @param can_frame a pointer to the structure to store the received CAN bus frame.
+ * @return zero if a frame was read, 1 if a frame was discarded, otherwise -1 if there was nothing to read or on error.
+ */
+int
+mcp2515_can_message_read_select(pi_mcp2515_t *pi_mcp2515, bool (*select)(uint8_t, void *), void *arg,
+    pi_mcp2515_can_frame_t *can_frame)
+{
+	int res = -1;
+	uint8_t rx_status;
+	mcp2515_rxb_t rxb;
+
+	rx_status = mcp2515_rx_status(pi_mcp2515);
+	if (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB0)
+		rxb = PI_MCP2515_RXB0;
+	else if (rx_status & PI_MCP2515_RX_STATUS_RCV_RXB1)
+		rxb = PI_MCP2515_RXB1;
+	else
+		goto end;
 
-	if (!(status & PI_MCP2515_RXBSIDL_SRR)) {
-		mcp2515_gpio_spi_read_blocking(pi_mcp2515, can_frame->payload, can_frame->dlc);
-		can_frame->rtr = true;
+	if (select(rx_status, arg)) {
+		res = can_read_rxb(pi_mcp2515, rxb, rx_status, can_frame);
+		goto end;
 	}
 
-	CS_HIGH(pi_mcp2515);
+	/* Just clearing the interrupt flag frees up the RX buffer. */
+	pi_mcp2515->rx_seen[rxb] = 0;
+	if (!mcp2515_register_bitmod(pi_mcp2515, 0, rxb == PI_MCP2515_RXB0 ? PI_MCP2515_CANINTF_RX0
+	    : PI_MCP2515_CANINTF_RX1, PI_MCP2515_RGSTR_CANINTF))
+		res = 1;
 
 end:
 	return (res);
 }
 
+/**
+ * @brief Read a CAN bus message from a specific RX buffer.
+ *
+ * The whole frame is read with a single READ RX BUFFER instruction, which also clears the RX buffer's interrupt flag.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rxb the RX buffer to read.
+ * @param can_frame a pointer to the structure to store the received CAN bus frame.
+ * @return zero if success, 1 if the software filter discarded the frame, otherwise -1.
+ */
+int
+mcp2515_can_message_read_rxb(pi_mcp2515_t *pi_mcp2515, mcp2515_rxb_t rxb, pi_mcp2515_can_frame_t *can_frame)
+{
+	if (rxb != PI_MCP2515_RXB0 && rxb != PI_MCP2515_RXB1)
+		return (-1);
+
+	return (can_read_rxb(pi_mcp2515, rxb, 0, can_frame));
+}
+
+/**
+ * @brief Read every CAN bus message waiting in the RX buffers, up to a maximum.
+ *
+ * After an initial status check, each SPI transaction reads all the full RX buffers at once, along with the status
+ * again to pick up anything which arrived in the meantime. This carries on until the RX buffers are empty, or @p max
+ * messages have been read. Where both RX buffers are full, RXB0 is read first. Messages the software filter discards
+ * aren't counted.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param can_frames an array to store the received CAN bus frames.
+ * @param max the length of the @p can_frames array.
+ * @param n set to the number of CAN bus frames read, which may be zero.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_can_message_read_batch(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_frame_t *can_frames, size_t max, size_t *n)
+{
+	static const uint8_t instrs[] = { PI_MCP2515_INSTR_READ_RX0, PI_MCP2515_INSTR_READ_RX1 };
+	pi_mcp2515_spi_seg_t segs[6];
+	int res = 0;
+	uint8_t buffers[2][MCP2515_FRAME_LEN], status_instr = PI_MCP2515_INSTR_READ_STATUS, status, i, seg_n, read_n;
+
+	*n = 0;
+	status = mcp2515_status(pi_mcp2515);
+
+	while (*n < max && (status & (PI_MCP2515_STATUS_RX0BF | PI_MCP2515_STATUS_RX1BF))) {
+		memset(segs, 0, sizeof(segs));
+		seg_n = read_n = 0;
+
+		/* RXnBF in the status is bit n. */
+		for (i = 0; i < 2 && *n + read_n < max; i++) {
+			if (!(status & (1 << i)))
+				continue;
+			pi_mcp2515->rx_seen[i] = 0;
+			segs[seg_n].tx = &instrs[i];
+			segs[seg_n++].len = 1;
+			segs[seg_n].rx = buffers[read_n++];
+			segs[seg_n].len = MCP2515_FRAME_LEN;
+			segs[seg_n++].cs_change = true;
+		}
+
+		/* Reading an RX buffer clears its flag, so only frames received since show up here. */
+		status = 0;
+		if (*n + read_n < max) {
+			segs[seg_n].tx = &status_instr;
+			segs[seg_n++].len = 1;
+			segs[seg_n].rx = &status;
+			segs[seg_n].len = 1;
+			segs[seg_n++].cs_change = true;
+		}
+
+		if ((res = mcp2515_spi_transfer(pi_mcp2515, segs, seg_n)))
+			break;
+		MCP2515_STAT_ADD(pi_mcp2515, frames_rx, read_n);
+
+		for (i = 0; i < read_n; i++) {
+			MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_RX, segs[2 * i].tx == &instrs[0] ? 0 : 1,
+			    MCP2515_TRACE_HDR(buffers[i]), buffers[i][4]);
+			if (!mcp2515_sw_filter_rx(pi_mcp2515, buffers[i]))
+				continue;
+			memset(&can_frames[*n], 0, sizeof(pi_mcp2515_can_frame_t));
+			mcp2515_can_frame_decode(buffers[i], &can_frames[(*n)++]);
+		}
+	}
+
+	return (res);
+}
+
 /**
  * @brief Check if there is a CAN bus message received.
  *
@@ -255,7 +1037,7 @@ end:
 bool
 mcp2515_can_message_received(pi_mcp2515_t *pi_mcp2515)
 {
-	return (!!(mcp2515_status(pi_mcp2515) & (PI_MCP2515_STATUS_RX0BF | PI_MCP2515_STATUS_RX0BF)));
+	return (!!(mcp2515_rx_status(pi_mcp2515) & PI_MCP2515_RX_STATUS_RCV_ALL));
 }
 
 /**
@@ -288,8 +1070,8 @@ void
 mcp2515_rts(pi_mcp2515_t *pi_mcp2515, uint8_t buffer)
 {
 	uint8_t instruction;
+	pi_mcp2515_spi_seg_t seg = { .tx = &instruction, .len = 1, .cs_change = true };
 
-	CS_LOW(pi_mcp2515);
 	switch (buffer) {
 	case 0:
 		instruction = PI_MCP2515_INSTR_RTS_TX0;
@@ -304,6 +1086,5 @@ mcp2515_rts(pi_mcp2515_t *pi_mcp2515, uint8_t buffer)
 		return;
 	}
 
-	mcp2515_gpio_spi_write_blocking(pi_mcp2515, &instruction, 1);
-	CS_HIGH(pi_mcp2515);
+	mcp2515_spi_transfer(pi_mcp2515, &seg, 1);
 }
\ No newline at end of file
@@ -0,0 +1,359 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The dispatch table calls a handler for each received frame, chosen by its ID. Standard IDs index straight into a
+ * table with a slot for each of the 2048 of them, with any masks already worked into it when they are registered.
+ * Extended IDs are looked up in an ID table (see id_table.c), and failing that, checked against the masks for extended
+ * IDs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define DISPATCH_STD_IDS 2048
+#define DISPATCH_EXT_MAX (1U << 16)
+#define DISPATCH_POLL_FRAMES 16 /* How many frames mcp2515_dispatch_poll reads at once. */
+
+struct dispatch_entry {
+	mcp2515_dispatch_handler_t handler;
+	void *arg;
+};
+
+struct dispatch_std {
+	struct dispatch_entry entry;
+	bool exact; /* Registered for the ID itself, rather than through a mask. */
+};
+
+struct dispatch_mask {
+	uint32_t id;
+	uint32_t mask;
+	bool extended_id;
+	struct dispatch_entry entry;
+};
+
+struct mcp2515_dispatch {
+	struct dispatch_std std[DISPATCH_STD_IDS];
+	struct mcp2515_id_table ext; /* Each with its struct dispatch_entry. */
+	struct dispatch_mask masks[PI_MCP2515_DISPATCH_MASKS_MAX]; /* Oldest first. */
+	uint8_t mask_count;
+	struct dispatch_entry fallback;
+	mcp2515_dispatch_batch_handler_t batch_handler;
+	void *batch_arg;
+};
+
+static void	dispatch_std_refresh(struct mcp2515_dispatch *, uint32_t);
+static const struct dispatch_entry	*dispatch_lookup(const struct mcp2515_dispatch *, uint32_t, bool);
+
+/* Work out which handler a standard ID not registered for itself gets, from the newest mask it matches. */
+static void
+dispatch_std_refresh(struct mcp2515_dispatch *d, uint32_t id)
+{
+	struct dispatch_std *slot = &d->std[id];
+	uint8_t i;
+
+	if (slot->exact)
+		return;
+
+	memset(&slot->entry, 0, sizeof(slot->entry));
+	for (i = d->mask_count; i-- > 0;) {
+		if (!d->masks[i].extended_id && !((id ^ d->masks[i].id) & d->masks[i].mask)) {
+			slot->entry = d->masks[i].entry;
+			break;
+		}
+	}
+}
+
+static const struct dispatch_entry *
+dispatch_lookup(const struct mcp2515_dispatch *d, uint32_t id, bool extended_id)
+{
+	uint32_t slot;
+	uint8_t i;
+
+	if (!extended_id)
+		return (&d->std[id & PI_MCP2515_CAN_ID_SFF_MASK].entry);
+
+	if (mcp2515_id_table_find(&d->ext, id, &slot))
+		return (mcp2515_id_table_value(&d->ext, slot));
+
+	for (i = d->mask_count; i-- > 0;) {
+		if (d->masks[i].extended_id && !((id ^ d->masks[i].id) & d->masks[i].mask))
+			return (&d->masks[i].entry);
+	}
+
+	return (&d->fallback);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_dispatch_functions Dispatch Functions
+ * @brief These functions handle calling a handler for each received CAN bus message, chosen by its ID.
+ *
+ * Handlers are registered for an ID, or for a range of IDs given by a mask. An ID registered for itself takes
+ * precedence over any mask, and otherwise the most recently registered mask which matches is used. Messages nothing is
+ * registered for go to the default handler, if there is one. Handlers are called from whichever thread dispatches the
+ * message, and must not register or unregister handlers themselves.
+ * @{
+ */
+/**
+ * @brief Set up the dispatch table, with nothing registered.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_dispatch_init(pi_mcp2515_t *pi_mcp2515)
+{
+	if (pi_mcp2515->dispatch != NULL)
+		return (-1);
+
+	if ((pi_mcp2515->dispatch = calloc(1, sizeof(struct mcp2515_dispatch))) == NULL)
+		return (-1);
+	mcp2515_id_table_init(&pi_mcp2515->dispatch->ext, sizeof(struct dispatch_entry), DISPATCH_EXT_MAX);
+
+	return (0);
+}
+
+/**
+ * @brief Free the dispatch table.
+ *
+ * This is also done automatically by mcp2515_free.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_dispatch_free(pi_mcp2515_t *pi_mcp2515)
+{
+	if (pi_mcp2515->dispatch == NULL)
+		return;
+
+	mcp2515_id_table_clear(&pi_mcp2515->dispatch->ext);
+	free(pi_mcp2515->dispatch);
+	pi_mcp2515->dispatch = NULL;
+}
+
+/**
+ * @brief Register a handler for an ID, replacing any already registered for it.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param id the ID.
+ * @param extended_id if the ID is extended.
+ * @param handler the handler, or NULL to unregister the ID.
+ * @param arg an arbitrary pointer passed to @p handler.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_dispatch_register(pi_mcp2515_t *pi_mcp2515, uint32_t id, bool extended_id,
+    mcp2515_dispatch_handler_t handler, void *arg)
+{
+	struct mcp2515_dispatch *d = pi_mcp2515->dispatch;
+	struct dispatch_entry *entry;
+	uint32_t slot;
+	int res = -1;
+
+	if (d == NULL || id > (extended_id ? PI_MCP2515_CAN_ID_EFF_MASK : PI_MCP2515_CAN_ID_SFF_MASK))
+		goto err;
+
+	if (!extended_id) {
+		d->std[id].exact = handler != NULL;
+		d->std[id].entry.handler = handler;
+		d->std[id].entry.arg = arg;
+		dispatch_std_refresh(d, id);
+		res = 0;
+		goto err;
+	}
+
+	if (handler == NULL) {
+		mcp2515_id_table_remove(&d->ext, id);
+		res = 0;
+		goto err;
+	}
+
+	if ((res = mcp2515_id_table_add(&d->ext, id, &slot)))
+		goto err;
+	entry = mcp2515_id_table_value(&d->ext, slot);
+	entry->handler = handler;
+	entry->arg = arg;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Register a handler for every ID matching @p id in the bits set in @p mask.
+ *
+ * Registering the same ID and mask again replaces the handler. Standard IDs are looked up as quickly with masks as
+ * without, but each mask for extended IDs is checked in turn, after looking up the ID itself.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param id the ID.
+ * @param mask the bits of the ID to match.
+ * @param extended_id if the IDs are extended.
+ * @param handler the handler, or NULL to unregister the ID and mask.
+ * @param arg an arbitrary pointer passed to @p handler.
+ * @return zero if success, otherwise non-zero, including if there are already PI_MCP2515_DISPATCH_MASKS_MAX masks.
+ */
+int
+mcp2515_dispatch_register_mask(pi_mcp2515_t *pi_mcp2515, uint32_t id, uint32_t mask, bool extended_id,
+    mcp2515_dispatch_handler_t handler, void *arg)
+{
+	struct mcp2515_dispatch *d = pi_mcp2515->dispatch;
+	uint32_t i;
+	uint8_t m;
+	int res = -1;
+
+	if (d == NULL)
+		goto err;
+	mask &= extended_id ? PI_MCP2515_CAN_ID_EFF_MASK : PI_MCP2515_CAN_ID_SFF_MASK;
+	id &= mask;
+
+	for (m = 0; m < d->mask_count; m++) {
+		if (d->masks[m].id == id && d->masks[m].mask == mask && d->masks[m].extended_id == extended_id)
+			break;
+	}
+	if (handler == NULL) {
+		if (m < d->mask_count)
+			memmove(&d->masks[m], &d->masks[m + 1], (size_t)(--d->mask_count - m) * sizeof(d->masks[0]));
+	} else {
+		if (m == d->mask_count) {
+			if (d->mask_count == PI_MCP2515_DISPATCH_MASKS_MAX)
+				goto err;
+			d->mask_count++;
+		}
+		d->masks[m] = (struct dispatch_mask){ .id = id, .mask = mask, .extended_id = extended_id,
+		    .entry = { .handler = handler, .arg = arg } };
+	}
+
+	if (!extended_id) {
+		for (i = 0; i < DISPATCH_STD_IDS; i++) {
+			if (!((i ^ id) & mask))
+				dispatch_std_refresh(d, i);
+		}
+	}
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Set the handler for messages nothing else is registered for.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param handler the handler, or NULL to ignore such messages.
+ * @param arg an arbitrary pointer passed to @p handler.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_dispatch_default(pi_mcp2515_t *pi_mcp2515, mcp2515_dispatch_handler_t handler, void *arg)
+{
+	if (pi_mcp2515->dispatch == NULL)
+		return (-1);
+
+	pi_mcp2515->dispatch->fallback.handler = handler;
+	pi_mcp2515->dispatch->fallback.arg = arg;
+
+	return (0);
+}
+
+/**
+ * @brief Set a handler to be called with each batch of messages mcp2515_dispatch_poll reads, after they have been
+ * dispatched one by one.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param handler the handler, or NULL for none.
+ * @param arg an arbitrary pointer passed to @p handler.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_dispatch_batch(pi_mcp2515_t *pi_mcp2515, mcp2515_dispatch_batch_handler_t handler, void *arg)
+{
+	if (pi_mcp2515->dispatch == NULL)
+		return (-1);
+
+	pi_mcp2515->dispatch->batch_handler = handler;
+	pi_mcp2515->dispatch->batch_arg = arg;
+
+	return (0);
+}
+
+/**
+ * @brief Call the handler registered for a CAN bus message.
+ *
+ * This is for messages received some other way, such as from mcp2515_rx_thread_read.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param can_frame the received CAN bus frame.
+ * @return zero if a handler was called, 1 if there was none for the message, otherwise -1.
+ */
+int
+mcp2515_dispatch_frame(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_can_frame_t *can_frame)
+{
+	const struct dispatch_entry *entry;
+
+	if (pi_mcp2515->dispatch == NULL)
+		return (-1);
+
+	entry = dispatch_lookup(pi_mcp2515->dispatch, can_frame->id, can_frame->extended_id);
+	if (entry->handler == NULL && (entry = &pi_mcp2515->dispatch->fallback)->handler == NULL)
+		return (1);
+	entry->handler(pi_mcp2515, can_frame, entry->arg);
+
+	return (0);
+}
+
+/**
+ * @brief Read every CAN bus message waiting in the RX buffers and dispatch each of them.
+ *
+ * Messages are read in batches with mcp2515_can_message_read_batch. Each message is passed to its handler, then the
+ * whole batch to the batch handler, if there is one.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param n set to how many messages were read, which may be zero. This may be NULL.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_dispatch_poll(pi_mcp2515_t *pi_mcp2515, size_t *n)
+{
+	struct mcp2515_dispatch *d = pi_mcp2515->dispatch;
+	pi_mcp2515_can_frame_t can_frames[DISPATCH_POLL_FRAMES];
+	size_t read_n, total = 0, i;
+	int res = -1;
+
+	if (d == NULL)
+		goto err;
+
+	do {
+		if ((res = mcp2515_can_message_read_batch(pi_mcp2515, can_frames, DISPATCH_POLL_FRAMES, &read_n)))
+			break;
+		for (i = 0; i < read_n; i++)
+			mcp2515_dispatch_frame(pi_mcp2515, &can_frames[i]);
+		if (read_n > 0 && d->batch_handler != NULL)
+			d->batch_handler(pi_mcp2515, can_frames, read_n, d->batch_arg);
+		total += read_n;
+	} while (read_n == DISPATCH_POLL_FRAMES);
+
+err:
+	if (n != NULL)
+		*n = total;
+
+	return (res);
+}
+/** @} */
@@ -144,4 +144,22 @@ end:
 	return (res);
 }
 
+/**
+ * @brief Set whether a frame accepted by RXB0 while it is full rolls over into RXB1 (BUKT).
+ *
+ * Without rollover, such a frame is lost and RX0OVR is set. With it, RXB1 acts as a second buffer for the frames RXB0
+ * accepts, which are still read from RXB0 first when both are full. This can be changed in any mode, and is left as it
+ * is by mcp2515_filter_enable_rxb.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param enable true to enable rollover.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_filter_rollover(pi_mcp2515_t *pi_mcp2515, const bool enable)
+{
+	return (mcp2515_register_bitmod(pi_mcp2515, enable ? PI_MCP2515_RXB0CTRL_BUKT : 0x00, PI_MCP2515_RXB0CTRL_BUKT,
+	    PI_MCP2515_RGSTR_RXB0CTRL));
+}
+
 /** @} */
\ No newline at end of file
@@ -0,0 +1,353 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The filter compiler works on cubes: sets of IDs given by the bits they must match, as each acceptance filter and its
+ * mask accept. IDs are laid out as in the filter registers, so a standard ID takes the top 11 of the 29 bits.
+ *
+ * The ranges asked for are split into aligned blocks, each an exact cube. Then the two cubes whose merger admits the
+ * fewest extra IDs are merged, over and over. Whenever six or fewer are left, every way of sharing them between RXB0
+ * (two filters) and RXB1 (four filters) is tried, with each RX buffer's mask being what its filters have in common, and
+ * the one admitting the fewest extra IDs overall is kept.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define FILTER_STD_BITS 0x1FFC0000UL
+#define FILTER_EID_BITS 0x0003FFFFUL
+
+struct filter_cube {
+	uint32_t value;
+	uint32_t mask;
+	bool ext;
+	uint64_t wanted; /* How many of the IDs asked for this covers. */
+};
+
+static int	filter_range_cmp(const void *, const void *);
+static uint64_t	filter_cube_size(uint32_t, bool);
+static uint64_t	filter_union_size(const struct filter_cube *, uint8_t, bool);
+static void	filter_plan_fill(const struct filter_cube *, uint8_t, uint8_t, pi_mcp2515_filter_plan_t *,
+    struct filter_cube *);
+
+static int
+filter_range_cmp(const void *a, const void *b)
+{
+	const pi_mcp2515_filter_range_t *ra = a, *rb = b;
+
+	if (ra->extended_id != rb->extended_id)
+		return (ra->extended_id ? 1 : -1);
+
+	return (ra->first < rb->first ? -1 : ra->first > rb->first);
+}
+
+static uint64_t
+filter_cube_size(uint32_t mask, bool ext)
+{
+	return ((uint64_t)1 << (ext ? 29 - __builtin_popcount(mask & PI_MCP2515_CAN_ID_EFF_MASK)
+	    : 11 - __builtin_popcount(mask & FILTER_STD_BITS)));
+}
+
+/**
+ * @brief Count the IDs of one type in a union of cubes, by inclusion-exclusion.
+ *
+ * @param cubes the cubes.
+ * @param n how many cubes (up to 6).
+ * @param ext whether to count extended or standard IDs.
+ * @return the number of IDs.
+ */
+static uint64_t
+filter_union_size(const struct filter_cube *cubes, uint8_t n, bool ext)
+{
+	int64_t res = 0;
+	uint32_t value, mask, set;
+	uint8_t bits, i;
+	bool empty;
+
+	for (set = 1; set < (1U << n); set++) {
+		value = 0;
+		mask = 0;
+		bits = 0;
+		empty = false;
+		for (i = 0; i < n && !empty; i++) {
+			if (!(set & (1U << i)))
+				continue;
+			if (cubes[i].ext != ext || ((value ^ cubes[i].value) & mask & cubes[i].mask))
+				empty = true;
+			value |= cubes[i].value;
+			mask |= cubes[i].mask;
+			bits++;
+		}
+		if (!empty)
+			res += (bits & 1 ? 1 : -1) * (int64_t)filter_cube_size(mask, ext);
+	}
+
+	return ((uint64_t)res);
+}
+
+/**
+ * @brief Lay out the filters for a way of sharing cubes between the RX buffers.
+ *
+ * Each RX buffer's mask keeps only the bits all its cubes care about. If it has any standard cubes, the mask leaves out
+ * the extended ID bits, which for standard frames are compared against the first two data bytes. Filters left spare
+ * repeat another in the same RX buffer, or if an RX buffer has no cubes, it repeats the other's.
+ *
+ * @param cubes the cubes.
+ * @param n how many cubes (up to 6).
+ * @param rxb0 the cubes going in RXB0 (up to 2), with bit 0 for the first cube and so on.
+ * @param plan where to put the filters and masks.
+ * @param out where to put the cubes each filter accepts.
+ */
+static void
+filter_plan_fill(const struct filter_cube *cubes, uint8_t n, uint8_t rxb0, pi_mcp2515_filter_plan_t *plan,
+    struct filter_cube *out)
+{
+	static const uint8_t first[2] = { 0, 2 }, slots[2] = { 2, 4 };
+	uint32_t mask;
+	uint8_t sets[2], g, i, slot;
+	bool std;
+
+	sets[0] = rxb0;
+	sets[1] = ((1 << n) - 1) & ~rxb0;
+	if (sets[0] == 0)
+		sets[0] = sets[1];
+	if (sets[1] == 0)
+		sets[1] = sets[0];
+
+	for (g = 0; g < 2; g++) {
+		mask = PI_MCP2515_CAN_ID_EFF_MASK;
+		std = false;
+		for (i = 0; i < n; i++) {
+			if (sets[g] & (1 << i)) {
+				mask &= cubes[i].mask;
+				std |= !cubes[i].ext;
+			}
+		}
+		if (std)
+			mask &= ~FILTER_EID_BITS;
+		plan->mask[g] = mask;
+
+		for (i = 0, slot = 0; i < n; i++) {
+			if (!(sets[g] & (1 << i)))
+				continue;
+			out[first[g] + slot].ext = cubes[i].ext;
+			out[first[g] + slot].mask = cubes[i].ext ? mask : mask & FILTER_STD_BITS;
+			out[first[g] + slot].value = cubes[i].value & out[first[g] + slot].mask;
+			slot++;
+		}
+		for (; slot < slots[g]; slot++)
+			out[first[g] + slot] = out[first[g]];
+	}
+
+	for (i = 0; i < 6; i++) {
+		plan->extended_id[i] = out[i].ext;
+		plan->filter[i] = out[i].ext ? out[i].value : out[i].value >> 18;
+	}
+}
+/*! @endcond */
+
+/**
+ * @addtogroup piMCP2515_filter_functions
+ * @{
+ */
+/**
+ * @brief Work out the masks and filters which accept a set of CAN IDs, while admitting as few other IDs as possible.
+ *
+ * This is a heuristic, which finds the best way of sharing filters between the RX buffers for the candidate filters it
+ * settles on, but doesn't try every possible set of filters. The IDs admitted beyond those asked for are counted in the
+ * plan, and mcp2515_filter_plan_accepts gives which they are. Nothing is written to the MCP2515 (see
+ * mcp2515_filter_plan_apply).
+ *
+ * @param ranges the ranges of IDs to accept, which may overlap.
+ * @param n how many ranges, which must split into no more than PI_MCP2515_FILTER_COMPILE_MAX aligned blocks.
+ * @param plan where to put the masks and filters.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_filter_compile(const pi_mcp2515_filter_range_t *ranges, size_t n, pi_mcp2515_filter_plan_t *plan)
+{
+	pi_mcp2515_filter_range_t *sorted = NULL;
+	pi_mcp2515_filter_plan_t candidate;
+	struct filter_cube *cubes = NULL, out[6];
+	uint64_t wanted[2] = { 0, 0 }, fp[2], best = UINT64_MAX;
+	int64_t delta, best_delta;
+	uint32_t first, last, block, mask;
+	size_t count = 0, m = 0, i, j, a = 0, b = 0;
+	uint8_t rxb0;
+	int res = -1;
+
+	if (n == 0)
+		goto err;
+	for (i = 0; i < n; i++)
+		if (ranges[i].first > ranges[i].last || ranges[i].last > (ranges[i].extended_id
+		    ? PI_MCP2515_CAN_ID_EFF_MASK : PI_MCP2515_CAN_ID_SFF_MASK))
+			goto err;
+	if ((sorted = malloc(n * sizeof(*sorted))) == NULL)
+		goto err;
+	if ((cubes = malloc(PI_MCP2515_FILTER_COMPILE_MAX * sizeof(*cubes))) == NULL)
+		goto err;
+
+	/* Merge overlapping and adjacent ranges, so the blocks they split into don't overlap. */
+	memcpy(sorted, ranges, n * sizeof(*sorted));
+	qsort(sorted, n, sizeof(*sorted), filter_range_cmp);
+	for (i = 1; i < n; i++) {
+		if (sorted[i].extended_id == sorted[m].extended_id && sorted[i].first <= sorted[m].last + 1) {
+			if (sorted[i].last > sorted[m].last)
+				sorted[m].last = sorted[i].last;
+		} else
+			sorted[++m] = sorted[i];
+	}
+
+	/* Split each range into the largest aligned blocks it holds. */
+	for (i = 0; i <= m; i++) {
+		first = sorted[i].first;
+		last = sorted[i].last;
+		for (;;) {
+			block = first != 0 ? first & -first : 1UL << 29;
+			while (block - 1 > last - first)
+				block >>= 1;
+			if (count == PI_MCP2515_FILTER_COMPILE_MAX)
+				goto err;
+
+			mask = ~(block - 1) & PI_MCP2515_CAN_ID_EFF_MASK;
+			cubes[count].ext = sorted[i].extended_id;
+			cubes[count].mask = cubes[count].ext ? mask : (mask << 18) & FILTER_STD_BITS;
+			cubes[count].value = cubes[count].ext ? first : first << 18;
+			cubes[count].wanted = block;
+			wanted[cubes[count].ext] += block;
+			count++;
+
+			if (last - first == block - 1)
+				break;
+			first += block;
+		}
+	}
+
+	for (;;) {
+		if (count <= 6) {
+			for (rxb0 = 0; rxb0 < (1 << count); rxb0++) {
+				if (__builtin_popcount(rxb0) > 2 || count - __builtin_popcount(rxb0) > 4)
+					continue;
+				filter_plan_fill(cubes, (uint8_t)count, rxb0, &candidate, out);
+				fp[0] = filter_union_size(out, 6, false) - wanted[0];
+				fp[1] = filter_union_size(out, 6, true) - wanted[1];
+				if (fp[0] + fp[1] < best) {
+					best = fp[0] + fp[1];
+					candidate.false_positives_std = (uint32_t)fp[0];
+					candidate.false_positives_ext = (uint32_t)fp[1];
+					memcpy(plan, &candidate, sizeof(*plan));
+				}
+			}
+		}
+
+		/* Merge the two cubes of the same type whose merger covers the fewest IDs the two didn't already. */
+		best_delta = INT64_MAX;
+		for (i = 0; i < count; i++) {
+			for (j = i + 1; j < count; j++) {
+				if (cubes[i].ext != cubes[j].ext)
+					continue;
+				mask = cubes[i].mask & cubes[j].mask & ~(cubes[i].value ^ cubes[j].value);
+				delta = (int64_t)filter_cube_size(mask, cubes[i].ext)
+				    - (int64_t)filter_cube_size(cubes[i].mask, cubes[i].ext)
+				    - (int64_t)filter_cube_size(cubes[j].mask, cubes[j].ext);
+				if (delta < best_delta) {
+					best_delta = delta;
+					a = i;
+					b = j;
+				}
+			}
+		}
+		if (best_delta == INT64_MAX)
+			break;
+
+		cubes[a].mask &= cubes[b].mask & ~(cubes[a].value ^ cubes[b].value);
+		cubes[a].value &= cubes[a].mask;
+		cubes[a].wanted += cubes[b].wanted;
+		cubes[b] = cubes[--count];
+	}
+	res = 0;
+
+err:
+	free(cubes);
+	free(sorted);
+
+	return (res);
+}
+
+/**
+ * @brief Check whether a set of masks and filters accepts a CAN ID.
+ *
+ * This follows how the MCP2515 applies them, except that for standard frames, the data bytes are ignored. Plans from
+ * mcp2515_filter_compile never compare them.
+ *
+ * @param plan the masks and filters.
+ * @param id the ID.
+ * @param extended_id if the ID is extended.
+ * @return true if the ID is accepted.
+ */
+bool
+mcp2515_filter_plan_accepts(const pi_mcp2515_filter_plan_t *plan, uint32_t id, bool extended_id)
+{
+	uint32_t mask, filter;
+	uint8_t i;
+
+	if (!extended_id)
+		id = (id & PI_MCP2515_CAN_ID_SFF_MASK) << 18;
+
+	for (i = 0; i < 6; i++) {
+		if (plan->extended_id[i] != extended_id)
+			continue;
+		mask = plan->mask[i < 2 ? 0 : 1] & (extended_id ? PI_MCP2515_CAN_ID_EFF_MASK : FILTER_STD_BITS);
+		filter = extended_id ? plan->filter[i] : plan->filter[i] << 18;
+		if (((id ^ filter) & mask) == 0)
+			return (true);
+	}
+
+	return (false);
+}
+
+/**
+ * @brief Write a set of masks and filters to the MCP2515, and turn filtering on.
+ *
+ * The MCP2515 must be in config mode to use this (see mcp2515_reqop and mcp2515_reqop_get).
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param plan the masks and filters, as from mcp2515_filter_compile.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_filter_plan_apply(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_filter_plan_t *plan)
+{
+	int res;
+	uint8_t i;
+
+	if ((res = mcp2515_filter_mask(pi_mcp2515, PI_MCP2515_RXM0, plan->mask[0], true)))
+		goto end;
+	if ((res = mcp2515_filter_mask(pi_mcp2515, PI_MCP2515_RXM1, plan->mask[1], true)))
+		goto end;
+	for (i = 0; i < 6; i++)
+		if ((res = mcp2515_filter(pi_mcp2515, (mcp2515_rxf_t)i, plan->filter[i], plan->extended_id[i])))
+			goto end;
+	res = mcp2515_filter_enable(pi_mcp2515, true);
+
+end:
+	return (res);
+}
+/** @} */
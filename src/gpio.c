@@ -95,6 +95,7 @@
 #ifdef USE_SPIDEV_LINUX
 #include <linux/gpio.h>
 #include <linux/spi/spidev.h>
+#include <poll.h>
 #elif defined(USE_SPI_BSD)
 /* <dev/spi/spi_io.h> and <sys/spigenio.h> are both absent on OpenBSD. <dev/spi/spivar.h> exists though. */
 #include <dev/spi/spi_io.h>
@@ -117,13 +118,59 @@ typedef struct gpio_pin gpio_set_t;
 
 /*! @cond DOXYGEN_IGNORE */
 
+#ifdef USE_SPIDEV_LINUX
+static ssize_t	gpio_int_events(pi_mcp2515_t *, int);
+
+/**
+ * @brief Read the INT line's edge events, keeping their timestamps to match to received frames.
+ *
+ * The kernel timestamps each edge with CLOCK_MONOTONIC as the interrupt comes in, which is far closer to when the frame
+ * arrived than anything measured after reading it.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param fd the INT line's file descriptor, which must be readable.
+ * @return the result of read(2).
+ */
+static ssize_t
+gpio_int_events(pi_mcp2515_t *pi_mcp2515, int fd)
+{
+	struct gpio_v2_line_event events[16];
+	ssize_t res;
+	size_t i;
+
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
+	if ((res = read(fd, events, sizeof(events))) > 0) {
+		for (i = 0; i < (size_t)res / sizeof(events[0]); i++)
+			mcp2515_int_edge_push(pi_mcp2515, events[i].timestamp_ns);
+	}
+
+	return (res);
+}
+
+/**
+ * @brief Poll the INT line's file descriptor for edges.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param pfd the INT line's poll(2) descriptor.
+ * @param timeout_ms how long to wait in milliseconds, or negative to wait indefinitely.
+ * @return the result of poll(2).
+ */
+static int
+gpio_int_poll(pi_mcp2515_t *pi_mcp2515, struct pollfd *pfd, int timeout_ms)
+{
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
+	return (poll(pfd, 1, timeout_ms));
+}
+#endif /* USE_SPIDEV_LINUX */
+
 #ifdef USE_SPI
-static int	spi_duplex_com(const pi_mcp2515_t *, char[sizeof(uint64_t)], size_t, char[sizeof(uint64_t)]);
+static int	spi_duplex_com(const pi_mcp2515_t *, char *, size_t, char *);
 
 /**
  * @brief Perform a round of full duplex communication over SPI.
  *
- * spidev only does duplex communication. So, we split that off to this function.
+ * spidev only does duplex communication. So, we split that off to this function. A single transfer may be up to
+ * `MCP2515_SPI_BURST_MAX` bytes, which is enough for an instruction, an address, and the entire register space.
  *
  * @param pi_mcp2515 the piMCP2515 handle.
  * @param tx_buffer the buffer to use for transmitting.
@@ -132,27 +179,28 @@ static int	spi_duplex_com(const pi_mcp2515_t *, char[sizeof(uint64_t)], size_t,
  * @return zero if success, otherwise non-zero.
  */
 static int
-spi_duplex_com(const pi_mcp2515_t *pi_mcp2515, char tx_buffer[sizeof(uint64_t)], /* NOLINT(*-non-const-parameter) */
-    size_t len, char rx_buffer[sizeof(uint64_t)]) /* NOLINT(*-non-const-parameter) */
+spi_duplex_com(const pi_mcp2515_t *pi_mcp2515, char *tx_buffer, /* NOLINT(*-non-const-parameter) */
+    size_t len, char *rx_buffer) /* NOLINT(*-non-const-parameter) */
 {
 	int res = 0;
 
-	if (len > sizeof(uint64_t)) {
+	if (len > MCP2515_SPI_BURST_MAX) {
 		res = -1;
 		goto err;
 	}
 #if defined(USE_SPIDEV_LINUX)
 	struct spi_ioc_transfer tr = { 0 };
 
-	tr.tx_buf = (uint64_t)(uint64_t *)tx_buffer;
-	tr.rx_buf = (uint64_t)(uint64_t *)rx_buffer;
+	tr.tx_buf = (uint64_t)(uintptr_t)tx_buffer;
+	tr.rx_buf = (uint64_t)(uintptr_t)rx_buffer;
 	tr.len = len;
 	tr.delay_usecs = pi_mcp2515->gpio_spi_delay_usec;
 	tr.speed_hz = pi_mcp2515->spi_clock;
 	tr.bits_per_word = pi_mcp2515->gpio_spi_bits_per_word;
 
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
 	res = ioctl(pi_mcp2515->gpio_spidev_fd, SPI_IOC_MESSAGE(1), &tr);
-	if (res == len)
+	if (res == (int)len)
 		res = 0;
 #elif defined(USE_SPI_BSD)
 	spi_ioctl_transfer_t tr = {
@@ -163,6 +211,7 @@ spi_duplex_com(const pi_mcp2515_t *pi_mcp2515, char tx_buffer[sizeof(uint64_t)],
 		/* .sit_addr ? */
 	};
 
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
 	res = ioctl(pi_mcp2515->gpio_spidev_fd, SPI_IOCTL_TRANSFER, &tr);
 #elif defined(USE_SPIGEN_BSD)
 	struct spigen_transfer transfer =  { 0 };
@@ -172,6 +221,7 @@ spi_duplex_com(const pi_mcp2515_t *pi_mcp2515, char tx_buffer[sizeof(uint64_t)],
 	transfer.st_data.iov_base = rx_buffer;
 	transfer.st_data.iov_len = len;
 
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
 	res = ioctl(pi_mcp2515->gpio_spidev_fd, SPIGENIOC_TRANSFER, &transfer);
 #endif
 
@@ -279,18 +329,26 @@ mcp2515_gpio_init(pi_mcp2515_t *pi_mcp2515, uint8_t pin)
 #elif defined(USE_SPIDEV_LINUX)
 	struct gpio_v2_line_request rq = { 0 };
 
+	if (pin >= PI_MCP2515_GPIO_PIN_MAP_LEN) {
+		res = -1;
+		goto end;
+	}
+
 	rq.offsets[0] = pin;
 	rq.num_lines = 1;
-	rq.config.flags = GPIOHANDLE_REQUEST_INPUT;
+	rq.config.flags = GPIO_V2_LINE_FLAG_INPUT;
 	rq.config.num_attrs = 0;
 	strncpy(rq.consumer, "pi_mcp2515", sizeof(rq.consumer));
 
-	res = ioctl(pi_mcp2515->gpio_gpio_fd, GPIO_GET_LINEHANDLE_IOCTL, &rq);
+	res = ioctl(pi_mcp2515->gpio_gpio_fd, GPIO_V2_GET_LINE_IOCTL, &rq);
 	if (!res)
 		pi_mcp2515->gpio_pin_fd_map[pin] = rq.fd;
+
+end:
 #elif defined(USE_BSD_GPIO)
 	gpio_set_t pin_config = { 0 };
 
+	pin_config.gp_pin = pin;
 	snprintf(pin_config.gp_name, GPIOMAXNAME, "pi_mcp2515 pin #%d", pin);
 	pin_config.gp_flags = GPIO_PIN_INPUT;
 
@@ -443,6 +501,12 @@ mcp2515_gpio_spi_init_full_optional(pi_mcp2515_t *pi_mcp2515, uint8_t mode, uint
 	pi_mcp2515->gpio_spidev_fd = spidev_fd;
 	pi_mcp2515->gpio_spi_mode = mode;
 
+	if ((res = mcp2515_gpio_cs_native(pi_mcp2515, false))) {
+		pi_mcp2515->gpio_gpio_fd = 0;
+		pi_mcp2515->gpio_spidev_fd = 0;
+		goto err;
+	}
+
 	goto end;
 
 err:
@@ -456,6 +520,64 @@ end:
 }
 
 
+/**
+ * @brief Choose between the SPI controller's native chip select and driving chip select via a GPIO line.
+ *
+ * For native chip select, the CS GPIO line is released (or never requested) and chip select is left entirely to the
+ * SPI controller, saving two GPIO ioctls per SPI command. Otherwise, the CS GPIO line is requested as an output and
+ * driven high.
+ *
+ * Native chip select is only available with spidev.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param native true to use native chip select, false to use the CS GPIO line.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_gpio_cs_native(pi_mcp2515_t *pi_mcp2515, bool native)
+{
+	int res = 0;
+
+#ifdef USE_SPIDEV_LINUX
+	if (native) {
+		if (pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->cs_pin] > 0) {
+			close(pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->cs_pin]);
+			pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->cs_pin] = 0;
+		}
+		pi_mcp2515->gpio_spi_native_cs = true;
+		goto end;
+	}
+
+	if (pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->cs_pin] <= 0
+	    && (res = mcp2515_gpio_init(pi_mcp2515, pi_mcp2515->cs_pin)))
+		goto end;
+#elif defined(USE_SPI)
+	if (native) {
+		res = -1;
+		goto end;
+	}
+
+	if ((res = mcp2515_gpio_init(pi_mcp2515, pi_mcp2515->cs_pin)))
+		goto end;
+#else
+	if (native) {
+		res = -1;
+		goto end;
+	}
+#endif
+#ifdef USE_SPI
+	if ((res = mcp2515_gpio_set_dir(pi_mcp2515, pi_mcp2515->cs_pin, true)))
+		goto end;
+
+	pi_mcp2515->gpio_spi_native_cs = false;
+	res = CS_HIGH(pi_mcp2515);
+#endif
+
+end:
+	return (res);
+}
+
+
 int
 mcp2515_gpio_set_dir(const pi_mcp2515_t *pi_mcp2515, uint8_t gpio, bool out)
 {
@@ -526,6 +648,127 @@ mcp2515_gpio_spi_read_blocking(pi_mcp2515_t *pi_mcp2515, uint8_t *data, uint8_t
 }
 
 
+static int	spi_command_transfer(pi_mcp2515_t *, const pi_mcp2515_spi_seg_t *, uint8_t);
+
+/**
+ * @brief Transfer the segments making up a single MCP2515 command.
+ *
+ * With spidev, the segments are chained into one `SPI_IOC_MESSAGE(N)` so the whole command costs a single syscall. On
+ * BSD, the segments are gathered into a single burst and what is read back is scattered across them afterward. On the
+ * Pico, each segment is transferred in turn. Chip select is left to the caller.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param segs the segments of the command.
+ * @param n the number of segments.
+ * @return zero if success, otherwise non-zero.
+ */
+static int
+spi_command_transfer(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_spi_seg_t *segs, uint8_t n)
+{
+	int res = 0;
+	uint8_t i;
+#ifdef USE_SPIDEV_LINUX
+	struct spi_ioc_transfer tr[n];
+	size_t total = 0;
+
+	memset(tr, 0, sizeof(tr));
+	for (i = 0; i < n; i++) {
+		tr[i].tx_buf = (uint64_t)(uintptr_t)segs[i].tx;
+		tr[i].rx_buf = (uint64_t)(uintptr_t)segs[i].rx;
+		tr[i].len = segs[i].len;
+		tr[i].delay_usecs = pi_mcp2515->gpio_spi_delay_usec;
+		tr[i].speed_hz = pi_mcp2515->spi_clock;
+		tr[i].bits_per_word = pi_mcp2515->gpio_spi_bits_per_word;
+		/* Only meaningful with native chip select, where a transfer can span several commands. */
+		tr[i].cs_change = segs[i].cs_change && i + 1 < n;
+		total += segs[i].len;
+	}
+
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
+	res = ioctl(pi_mcp2515->gpio_spidev_fd, SPI_IOC_MESSAGE(n), tr);
+	res = res == (int)total ? 0 : -1;
+#elif defined(USE_PICO_LIB)
+	for (i = 0; i < n; i++) {
+		if (segs[i].tx != NULL && segs[i].rx != NULL)
+			spi_write_read_blocking(pi_mcp2515->gpio_spi_inst, segs[i].tx, segs[i].rx, segs[i].len);
+		else if (segs[i].tx != NULL)
+			spi_write_blocking(pi_mcp2515->gpio_spi_inst, segs[i].tx, segs[i].len);
+		else if (segs[i].rx != NULL)
+			spi_read_blocking(pi_mcp2515->gpio_spi_inst, 0x00, segs[i].rx, segs[i].len);
+	}
+#elif defined(USE_SPI)
+	char tx_buffer[MCP2515_SPI_BURST_MAX], rx_buffer[MCP2515_SPI_BURST_MAX];
+	size_t total = 0;
+
+	for (i = 0; i < n && res == 0; i++) {
+		if (total + segs[i].len > sizeof(tx_buffer))
+			res = -1;
+		else if (segs[i].tx != NULL)
+			memcpy(&tx_buffer[total], segs[i].tx, segs[i].len);
+		else
+			memset(&tx_buffer[total], 0xff, segs[i].len);
+		total += segs[i].len;
+	}
+
+	if (res == 0)
+		res = spi_duplex_com(pi_mcp2515, tx_buffer, total, rx_buffer);
+
+	for (i = 0, total = 0; i < n && res == 0; i++) {
+		if (segs[i].rx != NULL)
+			memcpy(segs[i].rx, &rx_buffer[total], segs[i].len);
+		total += segs[i].len;
+	}
+#endif
+
+	return (res);
+}
+
+
+/**
+ * @brief Perform an SPI transaction made up of one or more MCP2515 commands.
+ *
+ * Each run of segments up to and including one with `cs_change` set (or the final segment) is a single command, and
+ * is transferred with chip select held low for its duration. With native chip select on spidev, the controller
+ * releases chip select between commands itself, so the whole transaction is submitted in a single ioctl.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param segs the segments of the transaction.
+ * @param n the number of segments.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_gpio_spi_transfer(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_spi_seg_t *segs, uint8_t n)
+{
+	int res = 0;
+	uint8_t i, start = 0;
+
+#ifdef USE_SPIDEV_LINUX
+	if (pi_mcp2515->gpio_spi_native_cs) {
+		res = spi_command_transfer(pi_mcp2515, segs, n);
+		goto end;
+	}
+#endif
+
+	for (i = 0; i < n; i++) {
+		if (!segs[i].cs_change && i + 1 < n)
+			continue;
+
+		CS_LOW(pi_mcp2515);
+		res = spi_command_transfer(pi_mcp2515, &segs[start], i - start + 1);
+		CS_HIGH(pi_mcp2515);
+		if (res)
+			break;
+
+		start = i + 1;
+	}
+
+#ifdef USE_SPIDEV_LINUX
+end:
+#endif
+	return (res);
+}
+
+
 int
 mcp2515_gpio_put(const pi_mcp2515_t *pi_mcp2515, uint8_t pin, uint8_t value)
 {
@@ -535,9 +778,11 @@ mcp2515_gpio_put(const pi_mcp2515_t *pi_mcp2515, uint8_t pin, uint8_t value)
 #elif defined(USE_SPIDEV_LINUX)
 	struct gpio_v2_line_values values;
 
-	values.mask = (1 << (pin - 1));
+	/* Each pin has its own single line request, so the line is always bit zero. */
+	values.mask = 1;
 	values.bits = value ? 1 : 0;
 
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
 	res = ioctl(pi_mcp2515->gpio_pin_fd_map[pin], GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
 #elif defined(USE_BSD_GPIO)
 	struct gpio_req pin_op;
@@ -545,10 +790,188 @@ mcp2515_gpio_put(const pi_mcp2515_t *pi_mcp2515, uint8_t pin, uint8_t value)
 	pin_op.gp_pin = pin;
 	pin_op.gp_value = value ? 1 : 0;
 
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
 	res = ioctl(pi_mcp2515->gpio_gpio_fd, GPIOWRITE, &pin_op);
 #endif
 
 	return (res);
 }
 
+
+int
+mcp2515_gpio_get(const pi_mcp2515_t *pi_mcp2515, uint8_t pin)
+{
+	int res;
+#ifdef USE_PICO_LIB
+	res = gpio_get(pin) ? 1 : 0;
+#elif defined(USE_SPIDEV_LINUX)
+	struct gpio_v2_line_values values = { 0 };
+
+	values.mask = 1;
+
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
+	res = ioctl(pi_mcp2515->gpio_pin_fd_map[pin], GPIO_V2_LINE_GET_VALUES_IOCTL, &values);
+	if (!res)
+		res = (int)(values.bits & 1);
+	else
+		res = -1;
+#elif defined(USE_BSD_GPIO)
+	struct gpio_req pin_op = { 0 };
+
+	pin_op.gp_pin = pin;
+
+	MCP2515_STAT_ADD(pi_mcp2515, syscalls, 1);
+	res = ioctl(pi_mcp2515->gpio_gpio_fd, GPIOREAD, &pin_op);
+	if (!res)
+		res = pin_op.gp_value ? 1 : 0;
+	else
+		res = -1;
+#else
+	res = -1;
+#endif
+
+	return (res);
+}
+
+
+/**
+ * @brief Set up the GPIO line connected to the MCP2515 INT pin.
+ *
+ * With spidev, the line is requested from the same GPIO chip as everything else, with falling edge events enabled so
+ * the line can be waited on without any polling.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param pin the GPIO pin connected to INT.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_gpio_int_init(pi_mcp2515_t *pi_mcp2515, uint8_t pin)
+{
+	int res = 0;
+#ifdef USE_PICO_LIB
+	gpio_init(pin);
+	gpio_set_dir(pin, false);
+#elif defined(USE_SPIDEV_LINUX)
+	struct gpio_v2_line_request rq = { 0 };
+
+	if (pin >= PI_MCP2515_GPIO_PIN_MAP_LEN) {
+		res = -1;
+		goto end;
+	}
+
+	rq.offsets[0] = pin;
+	rq.num_lines = 1;
+	rq.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	strncpy(rq.consumer, "pi_mcp2515 int", sizeof(rq.consumer));
+
+	if ((res = ioctl(pi_mcp2515->gpio_gpio_fd, GPIO_V2_GET_LINE_IOCTL, &rq)))
+		goto end;
+
+	if (pi_mcp2515->gpio_pin_fd_map[pin] > 0)
+		close(pi_mcp2515->gpio_pin_fd_map[pin]);
+	pi_mcp2515->gpio_pin_fd_map[pin] = rq.fd;
+
+end:
+#elif defined(USE_BSD_GPIO)
+	res = mcp2515_gpio_init(pi_mcp2515, pin);
+#endif
+	return (res);
+}
+
+
+/**
+ * @brief Wait for the MCP2515 INT pin to be asserted.
+ *
+ * INT is held low for as long as any enabled interrupt flag is set, so it is checked first in case the falling edge has
+ * already passed. With spidev, this then sleeps on the line's edge events. Elsewhere, the line is polled, which costs
+ * no SPI traffic but does wake up regularly.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param timeout_ms how long to wait in milliseconds, or negative to wait indefinitely.
+ * @return 1 if INT is asserted, 0 on timeout, or -1 on error.
+ */
+int
+mcp2515_gpio_int_wait(pi_mcp2515_t *pi_mcp2515, int timeout_ms)
+{
+	int res;
+#ifdef USE_SPIDEV_LINUX
+	struct pollfd pfd = { 0 };
+
+	pfd.fd = pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->int_pin];
+	pfd.events = POLLIN;
+
+	/* Edges from interrupts which have already been handled don't wake anything, but are kept for their timestamps. */
+	while ((res = gpio_int_poll(pi_mcp2515, &pfd, 0)) > 0) {
+		if (gpio_int_events(pi_mcp2515, pfd.fd) <= 0) {
+			res = -1;
+			goto end;
+		}
+	}
+	if (res < 0)
+		goto end;
+
+	if ((res = mcp2515_gpio_get(pi_mcp2515, pi_mcp2515->int_pin)) <= 0) {
+		res = res == 0 ? 1 : -1;
+		goto end;
+	}
+
+	if ((res = gpio_int_poll(pi_mcp2515, &pfd, timeout_ms)) > 0) {
+		if (gpio_int_events(pi_mcp2515, pfd.fd) <= 0)
+			res = -1;
+		else
+			res = 1;
+	}
+
+end:
+#else
+	long polls = timeout_ms < 0 ? -1 : (long)timeout_ms * 1000 / MCP2515_INT_POLL_USEC;
+
+	for (;;) {
+		if ((res = mcp2515_gpio_get(pi_mcp2515, pi_mcp2515->int_pin)) <= 0) {
+			res = res == 0 ? 1 : -1;
+			break;
+		}
+		if (polls == 0) {
+			res = 0;
+			break;
+		}
+		if (polls > 0)
+			polls--;
+		mcp2515_micro_sleep(MCP2515_INT_POLL_USEC);
+	}
+#endif
+	return (res);
+}
+
+
+/**
+ * @brief Collect the timestamps of any INT edges waiting to be read, without waiting for any more.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_gpio_int_drain(pi_mcp2515_t *pi_mcp2515)
+{
+#ifdef USE_SPIDEV_LINUX
+	struct pollfd pfd = { 0 };
+
+	pfd.fd = pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->int_pin];
+	pfd.events = POLLIN;
+
+	while (gpio_int_poll(pi_mcp2515, &pfd, 0) > 0 && gpio_int_events(pi_mcp2515, pfd.fd) > 0)
+		;
+#endif
+}
+
+
+int
+mcp2515_gpio_int_fd(const pi_mcp2515_t *pi_mcp2515)
+{
+#ifdef USE_SPIDEV_LINUX
+	return (pi_mcp2515->gpio_pin_fd_map[pi_mcp2515->int_pin]);
+#else
+	return (-1);
+#endif
+}
+
 /*! @endcond */
@@ -0,0 +1,221 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The ID table is a set of extended IDs, each optionally with a value alongside it, used by the software filter and the
+ * dispatch table. It is an open addressing hash table with linear probing, kept no more than half full, so a lookup is
+ * a multiply and, nearly always, one or two probes. IDs are removed by backward shift deletion, so no tombstones are
+ * left behind to lengthen later probes.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define ID_TABLE_MIN_BITS 4
+#define ID_TABLE_EMPTY 0xFFFFFFFFU /* Not a valid extended ID, so marks a free slot. */
+
+static uint32_t	id_table_hash(uint32_t, uint8_t);
+static uint32_t	id_table_probe(const struct mcp2515_id_table *, uint32_t);
+static void	id_table_move(struct mcp2515_id_table *, uint32_t, uint32_t);
+static int	id_table_grow(struct mcp2515_id_table *);
+
+/* Fibonacci hashing, which spreads runs of consecutive IDs evenly over the table. */
+static uint32_t
+id_table_hash(uint32_t id, uint8_t bits)
+{
+	return ((uint32_t)(id * 0x9E3779B1U) >> (32 - bits));
+}
+
+/* Find the slot for an ID, which is either its own or the free slot it would go in. */
+static uint32_t
+id_table_probe(const struct mcp2515_id_table *t, uint32_t id)
+{
+	uint32_t mask = (1U << t->bits) - 1, i;
+
+	for (i = id_table_hash(id, t->bits); t->ids[i] != ID_TABLE_EMPTY && t->ids[i] != id; i = (i + 1) & mask)
+		;
+
+	return (i);
+}
+
+static void
+id_table_move(struct mcp2515_id_table *t, uint32_t to, uint32_t from)
+{
+	t->ids[to] = t->ids[from];
+	if (t->value_size > 0)
+		memcpy(&t->values[to * t->value_size], &t->values[from * t->value_size], t->value_size);
+}
+
+static int
+id_table_grow(struct mcp2515_id_table *t)
+{
+	struct mcp2515_id_table old = *t;
+	uint32_t old_len = t->ids == NULL ? 0 : 1U << t->bits, i, slot;
+
+	t->bits = t->ids == NULL ? ID_TABLE_MIN_BITS : t->bits + 1;
+	t->values = NULL;
+	if ((t->ids = malloc(sizeof(uint32_t) << t->bits)) == NULL
+	    || (t->value_size > 0 && (t->values = malloc(t->value_size << t->bits)) == NULL)) {
+		free(t->ids);
+		*t = old;
+		return (-1);
+	}
+	memset(t->ids, 0xFF, sizeof(uint32_t) << t->bits);
+
+	for (i = 0; i < old_len; i++) {
+		if (old.ids[i] == ID_TABLE_EMPTY)
+			continue;
+		slot = id_table_probe(t, old.ids[i]);
+		t->ids[slot] = old.ids[i];
+		if (t->value_size > 0)
+			memcpy(&t->values[slot * t->value_size], &old.values[i * t->value_size], t->value_size);
+	}
+	free(old.ids);
+	free(old.values);
+
+	return (0);
+}
+
+/**
+ * @brief Set up an empty ID table, which allocates nothing until an ID is added.
+ *
+ * @param t the ID table.
+ * @param value_size the size of the value kept with each ID, which may be zero.
+ * @param max the most IDs the table may hold.
+ */
+void
+mcp2515_id_table_init(struct mcp2515_id_table *t, size_t value_size, uint32_t max)
+{
+	memset(t, 0, sizeof(*t));
+	t->value_size = value_size;
+	t->max = max;
+}
+
+/**
+ * @brief Remove every ID from an ID table, freeing its memory.
+ *
+ * @param t the ID table.
+ */
+void
+mcp2515_id_table_clear(struct mcp2515_id_table *t)
+{
+	free(t->ids);
+	free(t->values);
+	t->ids = NULL;
+	t->values = NULL;
+	t->bits = 0;
+	t->count = 0;
+}
+
+/**
+ * @brief Look up an ID.
+ *
+ * @param t the ID table.
+ * @param id the ID.
+ * @param slot if not NULL, set to the slot holding the ID, if it is in the table.
+ * @return true if the ID is in the table, otherwise false.
+ */
+bool
+mcp2515_id_table_find(const struct mcp2515_id_table *t, uint32_t id, uint32_t *slot)
+{
+	uint32_t i;
+
+	if (t->ids == NULL || t->ids[i = id_table_probe(t, id)] != id)
+		return (false);
+	if (slot != NULL)
+		*slot = i;
+
+	return (true);
+}
+
+/**
+ * @brief Get the value kept with the ID in a slot.
+ *
+ * @param t the ID table.
+ * @param slot the slot, from mcp2515_id_table_find or mcp2515_id_table_add.
+ * @return the value, which is only valid until the table is next changed.
+ */
+void *
+mcp2515_id_table_value(const struct mcp2515_id_table *t, uint32_t slot)
+{
+	return (&t->values[slot * t->value_size]);
+}
+
+/**
+ * @brief Add an ID, if it isn't already in the table.
+ *
+ * @param t the ID table.
+ * @param id the ID.
+ * @param slot if not NULL, set to the slot holding the ID. The value of a newly added ID is zeroed.
+ * @return zero if success, otherwise non-zero, including if the table already holds as many IDs as it may.
+ */
+int
+mcp2515_id_table_add(struct mcp2515_id_table *t, uint32_t id, uint32_t *slot)
+{
+	uint32_t i;
+
+	if (mcp2515_id_table_find(t, id, &i))
+		goto end;
+	if (t->count >= t->max)
+		return (-1);
+	if ((t->ids == NULL || (t->count + 1) * 2 > 1U << t->bits) && id_table_grow(t))
+		return (-1);
+
+	i = id_table_probe(t, id);
+	t->ids[i] = id;
+	if (t->value_size > 0)
+		memset(&t->values[i * t->value_size], 0, t->value_size);
+	t->count++;
+
+end:
+	if (slot != NULL)
+		*slot = i;
+
+	return (0);
+}
+
+/**
+ * @brief Remove an ID, if it is in the table.
+ *
+ * @param t the ID table.
+ * @param id the ID.
+ */
+void
+mcp2515_id_table_remove(struct mcp2515_id_table *t, uint32_t id)
+{
+	uint32_t mask, hole, i, home;
+
+	if (!mcp2515_id_table_find(t, id, &hole))
+		return;
+	mask = (1U << t->bits) - 1;
+
+	/* IDs after the hole which could live in it are moved up, so no probe sequence is broken. */
+	for (i = (hole + 1) & mask; t->ids[i] != ID_TABLE_EMPTY; i = (i + 1) & mask) {
+		home = id_table_hash(t->ids[i], t->bits);
+		/* Moving it to the hole is fine as long as its home slot isn't in between the two. */
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			id_table_move(t, hole, i);
+			hole = i;
+		}
+	}
+	t->ids[hole] = ID_TABLE_EMPTY;
+	t->count--;
+}
+/*! @endcond */
@@ -23,8 +23,14 @@
 
 /*! @cond DOXYGEN_IGNORE */
 
-#define CS_LOW(x) mcp2515_gpio_put(x, x->cs_pin, 0)
-#define CS_HIGH(x) mcp2515_gpio_put(x, x->cs_pin, 1)
+#ifdef USE_SPI
+/* With native chip select, the SPI controller drives its own CE line and there is nothing to do here. */
+#define CS_LOW(x) ((x)->gpio_spi_native_cs ? 0 : mcp2515_gpio_put(x, (x)->cs_pin, 0))
+#define CS_HIGH(x) ((x)->gpio_spi_native_cs ? 0 : mcp2515_gpio_put(x, (x)->cs_pin, 1))
+#else
+#define CS_LOW(x) mcp2515_gpio_put(x, (x)->cs_pin, 0)
+#define CS_HIGH(x) mcp2515_gpio_put(x, (x)->cs_pin, 1)
+#endif /* USE_SPI */
 
 #ifdef NO_DEBUG
 #define MCP2515_DEBUG(x, y, ...) (void)0/* NOOP */
@@ -32,14 +38,83 @@
 #define MCP2515_DEBUG(x, y, ...) __mcp2515_debug(x, y, ##__VA_ARGS__)
 #endif
 
+/*
+ * Record a trace event, with up to PI_MCP2515_TRACE_ARGS arguments, if tracing is set up (see trace.c). Unlike
+ * MCP2515_DEBUG, nothing is formatted, so it is cheap enough for the data path.
+ */
+#ifdef NO_TRACE
+#define MCP2515_TRACE(x, y, ...) (void)0/* NOOP */
+#else
+#define MCP2515_TRACE(x, y, ...) ((x)->trace == NULL ? (void)0 \
+    : mcp2515_trace_record(x, y, (const uint32_t[PI_MCP2515_TRACE_ARGS]){ __VA_ARGS__ }))
+#endif
+
+/* The SIDH, SIDL, EID8, and EID0 registers of a frame, packed into a trace event argument. */
+#define MCP2515_TRACE_HDR(x) ((uint32_t)(x)[0] << 24 | (uint32_t)(x)[1] << 16 | (uint32_t)(x)[2] << 8 | (x)[3])
+
 #ifdef USE_PICO_LIB
 #include "hardware/spi.h"
+#elif defined(USE_SPI)
+#include <pthread.h>
 #endif /* USE_PICO_LIB */
 
 #define PI_MCP2515_GPIO_PIN_MAP_LEN 26
 
+/* An instruction and address byte, followed by as much as the entire register space. */
+#define MCP2515_SPI_BURST_MAX (2 + PI_MCP2515_REGISTER_SPACE_LEN)
+
+/* Long enough for a maximum length frame at 10 kbps, with some room for losing arbitration. */
+#define MCP2515_TX_TIMEOUT_USEC 20000
+
+/* How often the interrupt flags are checked when waiting for an interrupt without an INT line. */
+#define MCP2515_INT_POLL_USEC 100
+
+/* The SIDH, SIDL, EID8, EID0, and DLC registers, followed by the payload, as laid out in the TX and RX buffers. */
+#define MCP2515_FRAME_LEN (5 + PI_MCP2515_CAN_FRAME_PAYLOAD_MAX)
+
+/* How many INT edge timestamps are kept, waiting to be matched to received frames. */
+#define MCP2515_INT_EDGES 8
+
+/*
+ * Statistics counters are updated without taking any lock, and read the same way by mcp2515_stats_get. On the Pico,
+ * a single core drives the handle and 64-bit atomics aren't native to the Cortex-M0+, so they are plain adds there.
+ * Some counters are bumped from functions given a const handle, hence the cast.
+ */
+#ifdef USE_PICO_LIB
+#define MCP2515_STAT_ADD(x, f, n) ((void)(((pi_mcp2515_t *)(x))->stats.f += (n)))
+#define MCP2515_STAT_LOAD(x, f) ((x)->stats.f)
+#define MCP2515_STAT_SET(x, f, n) ((void)((x)->stats.f = (n)))
+#else
+#define MCP2515_STAT_ADD(x, f, n) ((void)__atomic_add_fetch(&((pi_mcp2515_t *)(x))->stats.f, (n), __ATOMIC_RELAXED))
+#define MCP2515_STAT_LOAD(x, f) __atomic_load_n(&(x)->stats.f, __ATOMIC_RELAXED)
+#define MCP2515_STAT_SET(x, f, n) __atomic_store_n(&(x)->stats.f, (n), __ATOMIC_RELAXED)
+#endif /* USE_PICO_LIB */
+
+/* Commands to load a TX buffer and request to send it (see mcp2515_can_tx_load_prepare). */
+#define MCP2515_TX_LOAD_SEGS 5
+
+struct mcp2515_tx_load {
+	uint8_t clear[4];
+	uint8_t txp[4];
+	uint8_t instr;
+	uint8_t payload[MCP2515_FRAME_LEN];
+	uint8_t rts;
+};
+
+/* A set of extended IDs, each with an optional value (see id_table.c). */
+struct mcp2515_id_table {
+	uint32_t *ids;
+	uint8_t *values; /* value_size bytes for each slot, if value_size isn't zero. */
+	size_t value_size;
+	uint32_t max;
+	uint32_t count;
+	uint8_t bits; /* The table has 1 << bits slots. */
+};
+
 struct pi_mcp2515 {
 	void (*callback)(char *, va_list);
+	const pi_mcp2515_transport_t *transport;
+	void *transport_ctx;
 	uint8_t cs_pin;
 	uint32_t spi_clock;
 	uint8_t osc_mhz;
@@ -47,6 +122,28 @@ struct pi_mcp2515 {
 	uint8_t sck_pin;
 	uint8_t tx_pin;
 	uint8_t rx_pin;
+	uint8_t int_pin;
+	bool int_enabled;
+	uint8_t tx_pending; /* TX buffers sent asynchronously, whose completion hasn't been collected. */
+	uint8_t tx_queued; /* TX buffers in use by the TX queue. */
+	struct mcp2515_tx_queue *tx_queue;
+	uint8_t tx_mailbox; /* TX buffers bound as mailboxes. */
+	uint8_t tx_mailbox_len[3]; /* How much payload each mailbox sends. */
+	bool shadow_enabled;
+	uint8_t shadow[PI_MCP2515_RGSTR_CANINTE + 1]; /* The register shadow (see shadow.c). */
+	uint8_t shadow_valid[(PI_MCP2515_RGSTR_CANINTE + 8) / 8];
+	struct mcp2515_sw_filter *sw_filter;
+	struct mcp2515_dispatch *dispatch;
+	uint32_t rx_seq;
+	uint32_t rx_seen[2]; /* When each RX buffer was first seen full, for reading in order, or zero. */
+	uint64_t rx_stamp[2]; /* When each RX buffer's frame was received (see can_rx_observe). */
+	bool rx_stamp_edge[2];
+	uint64_t int_edges[MCP2515_INT_EDGES]; /* INT falling edge timestamps, oldest first from int_edge_head. */
+	uint8_t int_edge_head;
+	uint8_t int_edge_count;
+	pi_mcp2515_stats_t stats; /* Runtime counters, only accessed through the MCP2515_STAT_* macros. */
+	uint8_t stats_eflg; /* The EFLG bits already counted in stats. */
+	struct mcp2515_trace *trace;
 #ifdef USE_PICO_LIB
 	spi_inst_t *gpio_spi_inst;
 #elif defined(USE_SPI)
@@ -55,11 +152,14 @@ struct pi_mcp2515 {
 	int gpio_spidev_fd;
 	int gpio_gpio_fd;
 	uint8_t gpio_spi_mode;
+	bool gpio_spi_native_cs;
 #ifdef __linux__
 	uint8_t gpio_spi_bits_per_word;
 	uint16_t gpio_spi_delay_usec;
 	int gpio_pin_fd_map[PI_MCP2515_GPIO_PIN_MAP_LEN];
 #endif /* __linux__ */
+	pthread_mutex_t lock; /* Held for each transport transfer. */
+	struct mcp2515_rx_thread *rx_thread;
 #endif /* USE_PICO_LIB */
 };
 
@@ -68,13 +168,62 @@ extern "C" {
 #endif /* __cplusplus */
 
 int	mcp2515_gpio_init(pi_mcp2515_t *, uint8_t);
+int	mcp2515_gpio_cs_native(pi_mcp2515_t *, bool);
 int	mcp2515_gpio_set_dir(const pi_mcp2515_t *, uint8_t gpio, bool out);
 void	mcp2515_gpio_spi_free(const pi_mcp2515_t *);
 int	mcp2515_gpio_spi_init(pi_mcp2515_t *);
 int	mcp2515_gpio_spi_init_full_optional(pi_mcp2515_t *, uint8_t, uint8_t);
 int	mcp2515_gpio_spi_write_blocking(pi_mcp2515_t *, uint8_t[], uint8_t);
 int	mcp2515_gpio_spi_read_blocking(pi_mcp2515_t *, uint8_t[], uint8_t);
+int	mcp2515_gpio_spi_transfer(pi_mcp2515_t *, const pi_mcp2515_spi_seg_t *, uint8_t);
 int	mcp2515_gpio_put(const pi_mcp2515_t *, uint8_t, uint8_t);
+int	mcp2515_gpio_get(const pi_mcp2515_t *, uint8_t);
+int	mcp2515_gpio_int_init(pi_mcp2515_t *, uint8_t);
+int	mcp2515_gpio_int_wait(pi_mcp2515_t *, int);
+void	mcp2515_gpio_int_drain(pi_mcp2515_t *);
+int	mcp2515_gpio_int_fd(const pi_mcp2515_t *);
+
+extern const pi_mcp2515_transport_t mcp2515_transport_gpio;
+
+int	mcp2515_handle_alloc(pi_mcp2515_t **);
+void	mcp2515_handle_free(pi_mcp2515_t *);
+int	mcp2515_spi_transfer(pi_mcp2515_t *, const pi_mcp2515_spi_seg_t *, uint8_t);
+
+uint64_t	mcp2515_time_usec(void);
+uint64_t	mcp2515_time_nsec(void);
+
+void	mcp2515_int_edge_push(pi_mcp2515_t *, uint64_t);
+bool	mcp2515_int_edge_take(pi_mcp2515_t *, uint64_t, uint64_t *);
+
+bool	mcp2515_shadow_cached(const pi_mcp2515_t *, uint8_t, uint8_t);
+void	mcp2515_shadow_get(const pi_mcp2515_t *, uint8_t *, uint8_t, uint8_t);
+void	mcp2515_shadow_update(pi_mcp2515_t *, uint8_t, const uint8_t *, uint8_t, uint8_t);
+void	mcp2515_shadow_bitmod(pi_mcp2515_t *, uint8_t, uint8_t, uint8_t);
+
+void	mcp2515_stats_eflg(pi_mcp2515_t *, uint8_t);
+void	mcp2515_stats_eflg_clear(pi_mcp2515_t *, uint8_t);
+void	mcp2515_stats_eflg_write(pi_mcp2515_t *, const uint8_t *, uint8_t, uint8_t);
+
+void	mcp2515_trace_record(const pi_mcp2515_t *, uint16_t, const uint32_t *);
+
+void	mcp2515_id_table_init(struct mcp2515_id_table *, size_t, uint32_t);
+void	mcp2515_id_table_clear(struct mcp2515_id_table *);
+bool	mcp2515_id_table_find(const struct mcp2515_id_table *, uint32_t, uint32_t *);
+void	*mcp2515_id_table_value(const struct mcp2515_id_table *, uint32_t);
+int	mcp2515_id_table_add(struct mcp2515_id_table *, uint32_t, uint32_t *);
+void	mcp2515_id_table_remove(struct mcp2515_id_table *, uint32_t);
+
+bool	mcp2515_sw_filter_rx(pi_mcp2515_t *, const uint8_t *);
+
+uint8_t	mcp2515_can_frame_encode(const pi_mcp2515_can_frame_t *, uint8_t *);
+void	mcp2515_can_frame_decode(const uint8_t *, pi_mcp2515_can_frame_t *);
+uint8_t	mcp2515_wire_frame_len(const uint8_t *);
+void	mcp2515_wire_frame_from_rx(uint8_t *);
+uint8_t	mcp2515_can_tx_load_prepare(struct mcp2515_tx_load *, pi_mcp2515_spi_seg_t *, uint8_t, uint8_t,
+    const pi_mcp2515_can_frame_t *);
+uint8_t	mcp2515_can_tx_load_prepare_wire(struct mcp2515_tx_load *, pi_mcp2515_spi_seg_t *, uint8_t, uint8_t,
+    const uint8_t *);
+uint8_t	mcp2515_can_tx_free(const pi_mcp2515_t *, uint8_t);
 
 #ifndef NO_DEBUG
 void	__mcp2515_debug(pi_mcp2515_t *, char *, ...);
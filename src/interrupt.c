@@ -17,6 +17,52 @@
 
 #include "internal.h"
 
+/*! @cond DOXYGEN_IGNORE */
+/*
+ * The INT edges are only kept and taken by whichever thread waits on the INT pin, which is the RX thread while it is
+ * running, so need no lock.
+ */
+
+/**
+ * @brief Keep the timestamp of an INT falling edge, dropping the oldest kept if there are too many.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param nsec the timestamp, in nanoseconds of CLOCK_MONOTONIC.
+ */
+void
+mcp2515_int_edge_push(pi_mcp2515_t *pi_mcp2515, uint64_t nsec)
+{
+	pi_mcp2515->int_edges[(pi_mcp2515->int_edge_head + pi_mcp2515->int_edge_count) % MCP2515_INT_EDGES] = nsec;
+	if (pi_mcp2515->int_edge_count < MCP2515_INT_EDGES)
+		pi_mcp2515->int_edge_count++;
+	else
+		pi_mcp2515->int_edge_head = (pi_mcp2515->int_edge_head + 1) % MCP2515_INT_EDGES;
+}
+
+/**
+ * @brief Take the INT edges up to a point in time, giving the timestamp of the latest.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param before the latest timestamp to take.
+ * @param nsec set to the timestamp of the latest edge taken.
+ * @return true if any edges were taken, otherwise false.
+ */
+bool
+mcp2515_int_edge_take(pi_mcp2515_t *pi_mcp2515, uint64_t before, uint64_t *nsec)
+{
+	bool res = false;
+
+	while (pi_mcp2515->int_edge_count > 0 && pi_mcp2515->int_edges[pi_mcp2515->int_edge_head] <= before) {
+		*nsec = pi_mcp2515->int_edges[pi_mcp2515->int_edge_head];
+		pi_mcp2515->int_edge_head = (pi_mcp2515->int_edge_head + 1) % MCP2515_INT_EDGES;
+		pi_mcp2515->int_edge_count--;
+		res = true;
+	}
+
+	return (res);
+}
+/*! @endcond */
+
 /**
  * @defgroup piMCP2515_interrupt_functions Interrupt Functions
  * @brief These functions handle interrupt related functionality.
@@ -68,4 +114,113 @@ mcp2515_interrupts_clear(pi_mcp2515_t *pi_mcp2515)
 
 	mcp2515_register_write(pi_mcp2515, &zero, 1, PI_MCP2515_RGSTR_CANINTF);
 }
+
+/**
+ * @brief Choose which interrupts assert the INT pin.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param mask the interrupts to enable, as a bitwise OR of the CANINTE flags.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_interrupts_enable(pi_mcp2515_t *pi_mcp2515, uint8_t mask)
+{
+	return (mcp2515_register_write(pi_mcp2515, &mask, 1, PI_MCP2515_RGSTR_CANINTE));
+}
+
+/**
+ * @brief Set up the GPIO pin connected to the MCP2515 INT pin, for use by mcp2515_int_wait.
+ *
+ * This is only available for handles set up by mcp2515_init. Which interrupts assert INT is set with
+ * mcp2515_interrupts_enable.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param pin the GPIO pin connected to INT.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_int_init(pi_mcp2515_t *pi_mcp2515, uint8_t pin)
+{
+	int res = -1;
+
+	if (pi_mcp2515->transport != &mcp2515_transport_gpio)
+		goto err;
+
+	if ((res = mcp2515_gpio_int_init(pi_mcp2515, pin)))
+		goto err;
+
+	pi_mcp2515->int_pin = pin;
+	pi_mcp2515->int_enabled = true;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Wait for an enabled interrupt.
+ *
+ * If an INT pin has been set up with mcp2515_int_init, this waits on the pin and costs no SPI traffic at all while
+ * idle. Otherwise, the interrupt flags are polled over SPI instead.
+ *
+ * Returning doesn't clear anything, so this will keep returning immediately until the interrupt flags are cleared,
+ * such as by reading the RX buffers.
+ *
+ * With an INT pin, this must not be used while the RX thread is running (see mcp2515_rx_thread_start), which waits on
+ * the pin itself. The INT edges would be shared out between the two, and each could miss the other's.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param timeout_ms how long to wait in milliseconds, or negative to wait indefinitely.
+ * @return 1 if an interrupt is pending, 0 on timeout, or -1 on error.
+ */
+int
+mcp2515_int_wait(pi_mcp2515_t *pi_mcp2515, int timeout_ms)
+{
+	long polls = timeout_ms < 0 ? -1 : (long)timeout_ms * 1000 / MCP2515_INT_POLL_USEC;
+	int res;
+	uint8_t regs[2]; /* CANINTE and CANINTF */
+
+	if (pi_mcp2515->int_enabled) {
+		res = mcp2515_gpio_int_wait(pi_mcp2515, timeout_ms);
+		goto end;
+	}
+
+	for (;;) {
+		if (mcp2515_register_read(pi_mcp2515, regs, sizeof(regs), PI_MCP2515_RGSTR_CANINTE)) {
+			res = -1;
+			break;
+		}
+		if (regs[0] & regs[1]) {
+			res = 1;
+			break;
+		}
+		if (polls == 0) {
+			res = 0;
+			break;
+		}
+		if (polls > 0)
+			polls--;
+		mcp2515_micro_sleep(MCP2515_INT_POLL_USEC);
+	}
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Get a file descriptor which becomes readable when the INT pin is asserted.
+ *
+ * This allows waiting on the MCP2515 alongside other file descriptors with poll(2) and friends. Once it polls readable,
+ * call mcp2515_int_wait with a timeout of zero to consume the event and confirm the interrupt is still pending.
+ *
+ * This is only available with spidev, once mcp2515_int_init has been called. As for mcp2515_int_wait, it must not be
+ * used while the RX thread is running.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return the file descriptor, or -1 if unavailable.
+ */
+int
+mcp2515_int_fd(const pi_mcp2515_t *pi_mcp2515)
+{
+	return (pi_mcp2515->int_enabled ? mcp2515_gpio_int_fd(pi_mcp2515) : -1);
+}
 /** @} */
\ No newline at end of file
@@ -0,0 +1,137 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/**
+ * @defgroup piMCP2515_mailbox_functions TX Mailbox Functions
+ * @brief These functions handle sending cyclic CAN bus messages, whose ID and DLC never change.
+ *
+ * A mailbox is a TX buffer loaded once with a message's ID and DLC. Each send then only loads the payload, with the
+ * LOAD TX BUFFER instructions that start at the first data byte, and requests to send. While bound, the TX buffer is
+ * not used by any other send function.
+ * @{
+ */
+/**
+ * @brief Bind a TX buffer as a mailbox for a message.
+ *
+ * The whole message is loaded, but not sent.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param txb the TX buffer (0-2), which must be free.
+ * @param can_frame the CAN bus frame, whose ID, DLC, and type are kept for every send.
+ * @param txp the transmit priority (0-3), where 3 is the highest.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_can_mailbox_bind(pi_mcp2515_t *pi_mcp2515, uint8_t txb, const pi_mcp2515_can_frame_t *can_frame,
+    uint8_t txp)
+{
+	struct mcp2515_tx_load load;
+	pi_mcp2515_spi_seg_t segs[MCP2515_TX_LOAD_SEGS];
+	int res = -1;
+
+	if (txb > 2 || !(mcp2515_can_tx_free(pi_mcp2515, mcp2515_status(pi_mcp2515)) & (1 << txb)))
+		goto err;
+
+	/* Everything but the RTS, which is the last segment. */
+	if ((res = mcp2515_spi_transfer(pi_mcp2515, segs,
+	    mcp2515_can_tx_load_prepare(&load, segs, txb, txp, can_frame) - 1)))
+		goto err;
+
+	pi_mcp2515->tx_mailbox |= 1 << txb;
+	pi_mcp2515->tx_mailbox_len[txb] = segs[3].len - 5;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Send a mailbox's message with a new payload.
+ *
+ * This takes one READ STATUS, to check the previous send has finished, and one SPI transaction to load the payload and
+ * request to send, which also clears TXnIF if the previous send set it.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param txb the mailbox's TX buffer (0-2).
+ * @param payload the payload, as long as the DLC the mailbox was bound with. This is ignored for remote frames.
+ * @return zero if success, 1 if the previous send is still pending, otherwise -1.
+ */
+int
+mcp2515_can_mailbox_send(pi_mcp2515_t *pi_mcp2515, uint8_t txb, const uint8_t *payload)
+{
+	pi_mcp2515_spi_seg_t segs[4];
+	int res = -1;
+	uint8_t clear[4], instr, rts, status, n = 0;
+
+	if (txb > 2 || !(pi_mcp2515->tx_mailbox & (1 << txb)))
+		goto end;
+
+	status = mcp2515_status(pi_mcp2515);
+	if (status & (PI_MCP2515_STATUS_TX0REQ << (txb * 2))) {
+		res = 1;
+		goto end;
+	}
+
+	memset(segs, 0, sizeof(segs));
+	if (status & (PI_MCP2515_STATUS_TX0IF << (txb * 2))) {
+		clear[0] = PI_MCP2515_INSTR_BITMOD;
+		clear[1] = PI_MCP2515_RGSTR_CANINTF;
+		clear[2] = PI_MCP2515_CANINTF_TX0IF << txb;
+		clear[3] = 0;
+		segs[n].tx = clear;
+		segs[n].len = sizeof(clear);
+		segs[n++].cs_change = true;
+	}
+	if (pi_mcp2515->tx_mailbox_len[txb] > 0) {
+		instr = PI_MCP2515_INSTR_LOAD_TX0_D0 + (txb << 1);
+		segs[n].tx = &instr;
+		segs[n++].len = 1;
+		segs[n].tx = payload;
+		segs[n].len = pi_mcp2515->tx_mailbox_len[txb];
+		segs[n++].cs_change = true;
+	}
+	rts = PI_MCP2515_INSTR_RTS | (1 << txb);
+	segs[n].tx = &rts;
+	segs[n++].len = 1;
+
+	/* The previous send is only known to have gone out now, once its TXnIF is seen. */
+	res = mcp2515_spi_transfer(pi_mcp2515, segs, n) ? -1 : 0;
+	if (res == 0 && (status & (PI_MCP2515_STATUS_TX0IF << (txb * 2))))
+		MCP2515_STAT_ADD(pi_mcp2515, frames_tx, 1);
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Unbind a mailbox, so its TX buffer can be used by the other send functions again.
+ *
+ * A send still pending is left to finish.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param txb the mailbox's TX buffer (0-2).
+ */
+void
+mcp2515_can_mailbox_unbind(pi_mcp2515_t *pi_mcp2515, uint8_t txb)
+{
+	if (txb < 3)
+		pi_mcp2515->tx_mailbox &= ~(1 << txb);
+}
+/** @} */
@@ -18,7 +18,6 @@
  */
 
 #include <stdbool.h>
-#include <stdlib.h>
 
 #include <pi_MCP2515.h>
 
@@ -110,12 +109,11 @@ mcp2515_bitrate_full_optional(pi_mcp2515_t *pi_mcp2515, uint16_t baud_rate_kbps,
 
 	if ((res = mcp2515_register_write(pi_mcp2515, &cnf1, 1, PI_MCP2515_RGSTR_CNF1)))
 		goto err;
-	MCP2515_DEBUG(pi_mcp2515, "Wrote 0x%02x to CNF1\n", cnf1);
 	if ((res = mcp2515_register_write(pi_mcp2515, &cnf2, 1, PI_MCP2515_RGSTR_CNF2)))
 		goto err;
-	MCP2515_DEBUG(pi_mcp2515, "Wrote 0x%02x to CNF2\n", cnf2);
-	res = mcp2515_register_write(pi_mcp2515, &cnf3, 1, PI_MCP2515_RGSTR_CNF3);
-	MCP2515_DEBUG(pi_mcp2515, "Wrote 0x%02x to CNF3\n", cnf3);
+	if ((res = mcp2515_register_write(pi_mcp2515, &cnf3, 1, PI_MCP2515_RGSTR_CNF3)))
+		goto err;
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_CNF, cnf1, cnf2, cnf3);
 
 err:
 	return (res);
@@ -200,13 +198,15 @@ mcp2515_init(pi_mcp2515_t **pi_mcp2515, uint8_t spi_channel, uint8_t tx_pin, uin
 {
 	int res;
 
-	*pi_mcp2515 = calloc(1, sizeof(pi_mcp2515_t));
+	if ((res = mcp2515_handle_alloc(pi_mcp2515)))
+		goto err;
 
 	if (osc_mhz > 40 || osc_mhz == 0 || spi_channel > 1) {
 		res = 1;
 		goto err;
 	}
 
+	(*pi_mcp2515)->transport = &mcp2515_transport_gpio;
 	(*pi_mcp2515)->spi_channel = spi_channel;
 	(*pi_mcp2515)->sck_pin = sck_pin;
 	(*pi_mcp2515)->tx_pin = tx_pin;
@@ -251,6 +251,27 @@ mcp2515_conf_spi_devpath(pi_mcp2515_t *pi_mcp2515, char *spidev_path)
 #endif
 }
 
+/**
+ * @brief Use the SPI controller's native chip select instead of driving chip select from a GPIO line.
+ *
+ * Only supported with spidev on Linux. With native chip select, the CS GPIO line is released and chip select is left
+ * to the SPI controller's own CE line, which saves two GPIO ioctls for every SPI command, and lets several MCP2515
+ * commands be submitted in a single ioctl. The `cs_pin` given to `mcp2515_init` is then ignored, and the MCP2515 must be
+ * wired to the CE line of the SPI device in use.
+ *
+ * The CS GPIO line is always requested during init, so `cs_pin` must be a line that is free to request even if native
+ * chip select is to be used afterwards, and not one of the CE lines already claimed by the SPI controller.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param native true to use native chip select, false to drive chip select from the CS GPIO line.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_conf_spi_native_cs(pi_mcp2515_t *pi_mcp2515, bool native)
+{
+	return (mcp2515_gpio_cs_native(pi_mcp2515, native));
+}
+
 /**
  * @brief Override the default path for the gpio device (ex /dev/gpio0).
  *
@@ -281,7 +302,6 @@ mcp2515_conf_gpio_devpath(pi_mcp2515_t *pi_mcp2515, char *gpiodev_path)
 void
 mcp2515_free(pi_mcp2515_t *pi_mcp2515)
 {
-	mcp2515_gpio_spi_free(pi_mcp2515);
-	free(pi_mcp2515);
+	mcp2515_handle_free(pi_mcp2515);
 }
 /** @} */
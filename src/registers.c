@@ -13,10 +13,72 @@
  * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <stddef.h>
+
 #include <pi_MCP2515.h>
 
 #include "internal.h"
 
+static int	register_burst(pi_mcp2515_t *, uint8_t, const pi_mcp2515_iovec_t *, uint8_t, mcp2515_rgstr_t);
+
+/**
+ * @brief Read or write consecutive registers in a single burst spread across several buffers.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param instr either the READ or WRITE instruction.
+ * @param iov the buffers, in register order.
+ * @param iovcnt the number of buffers (1-PI_MCP2515_IOV_MAX).
+ * @param rgstr the first register of the burst.
+ * @return zero if success, otherwise non-zero.
+ */
+static int
+register_burst(pi_mcp2515_t *pi_mcp2515, const uint8_t instr, const pi_mcp2515_iovec_t *iov, const uint8_t iovcnt,
+    const mcp2515_rgstr_t rgstr)
+{
+	int res = -1;
+	size_t total = 0;
+	uint8_t message[2], addr, i;
+	pi_mcp2515_spi_seg_t segs[PI_MCP2515_IOV_MAX + 1] = { { .tx = message, .len = 2 } };
+
+	if (iovcnt == 0 || iovcnt > PI_MCP2515_IOV_MAX)
+		goto err;
+
+	for (i = 0; i < iovcnt; i++) {
+		if (instr == PI_MCP2515_INSTR_READ)
+			segs[i + 1].rx = iov[i].base;
+		else
+			segs[i + 1].tx = iov[i].base;
+		segs[i + 1].len = iov[i].len;
+		total += iov[i].len;
+	}
+	segs[iovcnt].cs_change = true;
+
+	if ((size_t)rgstr + total > PI_MCP2515_REGISTER_SPACE_LEN)
+		goto err;
+
+	if (instr == PI_MCP2515_INSTR_READ && mcp2515_shadow_cached(pi_mcp2515, (uint8_t)total, rgstr)) {
+		for (i = 0, addr = rgstr; i < iovcnt; addr += iov[i].len, i++)
+			mcp2515_shadow_get(pi_mcp2515, iov[i].base, iov[i].len, addr);
+		res = 0;
+		goto err;
+	}
+
+	message[0] = instr;
+	message[1] = (uint8_t)rgstr;
+
+	if ((res = mcp2515_spi_transfer(pi_mcp2515, segs, iovcnt + 1)))
+		goto err;
+
+	for (i = 0, addr = rgstr; i < iovcnt; addr += iov[i].len, i++) {
+		mcp2515_shadow_update(pi_mcp2515, instr, iov[i].base, iov[i].len, addr);
+		if (instr == PI_MCP2515_INSTR_WRITE)
+			mcp2515_stats_eflg_write(pi_mcp2515, iov[i].base, iov[i].len, addr);
+	}
+
+err:
+	return (res);
+}
+
 /**
  * @defgroup piMCP2515_register_functions Register Functions
  * @brief These functions handle manipulating values in the MCP2515's registers.
@@ -34,19 +96,23 @@
 int
 mcp2515_register_read(pi_mcp2515_t *pi_mcp2515, uint8_t *data, uint8_t len, const mcp2515_rgstr_t rgstr)
 {
-	int res;
 	uint8_t message[2];
+	pi_mcp2515_spi_seg_t segs[2] = {
+		{ .tx = message, .len = 2 },
+		{ .rx = data, .len = len, .cs_change = true },
+	};
+	int res;
+
+	if (mcp2515_shadow_cached(pi_mcp2515, len, rgstr)) {
+		mcp2515_shadow_get(pi_mcp2515, data, len, rgstr);
+		return (0);
+	}
 
-	CS_LOW(pi_mcp2515);
 	message[0] = PI_MCP2515_INSTR_READ;
 	message[1] = (uint8_t)rgstr;
-	res = mcp2515_gpio_spi_write_blocking(pi_mcp2515, message, 2);
-	if (res)
-		goto err;
-	res = mcp2515_gpio_spi_read_blocking(pi_mcp2515, data, len);
 
-err:
-	CS_HIGH(pi_mcp2515);
+	if (!(res = mcp2515_spi_transfer(pi_mcp2515, segs, 2)))
+		mcp2515_shadow_update(pi_mcp2515, PI_MCP2515_INSTR_READ, data, len, rgstr);
 
 	return (res);
 }
@@ -63,20 +129,20 @@ err:
 int
 mcp2515_register_write(pi_mcp2515_t *pi_mcp2515, uint8_t values[], const uint8_t len, const mcp2515_rgstr_t rgstr)
 {
-	int res;
 	uint8_t message[2];
+	pi_mcp2515_spi_seg_t segs[2] = {
+		{ .tx = message, .len = 2 },
+		{ .tx = values, .len = len, .cs_change = true },
+	};
+	int res;
 
-	CS_LOW(pi_mcp2515);
 	message[0] = PI_MCP2515_INSTR_WRITE;
 	message[1] = (uint8_t)rgstr;
 
-	res = mcp2515_gpio_spi_write_blocking(pi_mcp2515, message, 2);
-	if (res)
-		goto err;
-	res = mcp2515_gpio_spi_write_blocking(pi_mcp2515, values, len);
-
-err:
-	CS_HIGH(pi_mcp2515);
+	if (!(res = mcp2515_spi_transfer(pi_mcp2515, segs, 2))) {
+		mcp2515_shadow_update(pi_mcp2515, PI_MCP2515_INSTR_WRITE, values, len, rgstr);
+		mcp2515_stats_eflg_write(pi_mcp2515, values, len, rgstr);
+	}
 
 	return (res);
 }
@@ -93,17 +159,57 @@ err:
 int
 mcp2515_register_bitmod(pi_mcp2515_t *pi_mcp2515, const uint8_t data, const uint8_t mask, const mcp2515_rgstr_t rgstr)
 {
-	int res;
 	uint8_t message[4];
+	pi_mcp2515_spi_seg_t seg = { .tx = message, .len = 4, .cs_change = true };
+	int res;
 
-	CS_LOW(pi_mcp2515);
 	message[0] = PI_MCP2515_INSTR_BITMOD;
 	message[1] = (uint8_t)rgstr;
 	message[2] = mask;
 	message[3] = data;
-	res = mcp2515_gpio_spi_write_blocking(pi_mcp2515, message, 4);
-	CS_HIGH(pi_mcp2515);
+
+	if (!(res = mcp2515_spi_transfer(pi_mcp2515, &seg, 1))) {
+		mcp2515_shadow_bitmod(pi_mcp2515, data, mask, rgstr);
+		/* Overflow flags cleared here are counted again when next set. */
+		if (rgstr == PI_MCP2515_RGSTR_EFLG)
+			mcp2515_stats_eflg_clear(pi_mcp2515, mask & ~data);
+	}
 
 	return (res);
 }
+
+/**
+ * @brief Read consecutive registers in a single burst, scattering the data read across several buffers.
+ *
+ * The burst may span up to the entire register space, for example an RX buffer's control register, header, and payload
+ * into separate buffers.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param iov the buffers to read into, in register order.
+ * @param iovcnt the number of buffers (1-PI_MCP2515_IOV_MAX).
+ * @param rgstr the first register to read.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_register_readv(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_iovec_t *iov, const uint8_t iovcnt,
+    const mcp2515_rgstr_t rgstr)
+{
+	return (register_burst(pi_mcp2515, PI_MCP2515_INSTR_READ, iov, iovcnt, rgstr));
+}
+
+/**
+ * @brief Write consecutive registers in a single burst, gathering the data written from several buffers.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param iov the buffers to write from, in register order.
+ * @param iovcnt the number of buffers (1-PI_MCP2515_IOV_MAX).
+ * @param rgstr the first register to write.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_register_writev(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_iovec_t *iov, const uint8_t iovcnt,
+    const mcp2515_rgstr_t rgstr)
+{
+	return (register_burst(pi_mcp2515, PI_MCP2515_INSTR_WRITE, iov, iovcnt, rgstr));
+}
 /** @} */
\ No newline at end of file
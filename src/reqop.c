@@ -37,13 +37,11 @@ mcp2515_reset(pi_mcp2515_t *pi_mcp2515)
 {
 	int res;
 	uint8_t instr = PI_MCP2515_INSTR_RESET, blank[14] = { 0 };
+	pi_mcp2515_spi_seg_t seg = { .tx = &instr, .len = 1, .cs_change = true };
 
-	CS_LOW(pi_mcp2515);
-	res = mcp2515_gpio_spi_write_blocking(pi_mcp2515, &instr, 1);
-	CS_HIGH(pi_mcp2515);
-
-	if (res)
+	if ((res = mcp2515_spi_transfer(pi_mcp2515, &seg, 1)))
 		goto err;
+	mcp2515_shadow_invalidate(pi_mcp2515);
 
 	mcp2515_micro_sleep(mcp2515_osc_time(pi_mcp2515, MCP2515_REQOP_CHANGE_SLEEP_CYCLES));
 
@@ -84,7 +82,7 @@ mcp2515_reqop(pi_mcp2515_t *pi_mcp2515, const mcp2515_reqop_t reqop)
 {
 	int res;
 
-	MCP2515_DEBUG(pi_mcp2515, "mcp2515_reqop changing to 0x%02x\n", reqop);
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_REQOP, reqop);
 
 	res = mcp2515_register_bitmod(pi_mcp2515, (uint8_t)reqop, PI_MCP2515_REQOP_MASK, (uint8_t)PI_MCP2515_RGSTR_CANCTRL);
 	mcp2515_micro_sleep(mcp2515_osc_time(pi_mcp2515, MCP2515_REQOP_CHANGE_SLEEP_CYCLES));
@@ -0,0 +1,390 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The RX thread drains the MCP2515 RX buffers into a single-producer/single-consumer ring as soon as frames arrive, so
+ * the application can take its time processing them without the MCP2515's two RX buffers overrunning.
+ *
+ * The ring is lock-free. The RX thread only ever writes `head`, and the consumer only ever writes `tail`, each on its
+ * own cache line so neither side bounces the other's line around. Each side also keeps its own copy of the other's
+ * index, which is only refreshed when the ring looks full (or empty), to save touching the shared line at all in the
+ * common case. A mutex and condition variable are only involved when the consumer actually has to sleep.
+ *
+ * This needs pthreads, so it isn't available on the Pico.
+ */
+
+#ifdef USE_SPI
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define RX_THREAD_CACHE_LINE 64
+#define RX_THREAD_RING_MAX (1U << 16)
+#define RX_THREAD_WAKE_MS 50 /* How often the RX thread checks if it should stop. */
+
+struct mcp2515_rx_thread {
+	/* Producer (RX thread) side. */
+	uint32_t head __attribute__((aligned(RX_THREAD_CACHE_LINE)));
+	uint32_t tail_cache;
+	pi_mcp2515_rx_thread_stats_t stats;
+
+	/* Consumer side. */
+	uint32_t tail __attribute__((aligned(RX_THREAD_CACHE_LINE)));
+	uint32_t head_cache;
+	bool waiting;
+
+	/* Read-only once started. */
+	pi_mcp2515_can_rx_frame_t *frames __attribute__((aligned(RX_THREAD_CACHE_LINE)));
+	uint32_t mask;
+	mcp2515_rx_overflow_t overflow;
+	bool stop;
+	pthread_t thread;
+	pthread_mutex_t wait_lock;
+	pthread_cond_t wait_cond;
+};
+
+static int	rx_thread_drain(pi_mcp2515_t *, struct mcp2515_rx_thread *);
+static void	*rx_thread_main(void *);
+static int	rx_thread_wait(struct mcp2515_rx_thread *, int);
+
+/**
+ * @brief Move the next frame from the RX buffers into the ring, with where and when it was received.
+ *
+ * Where both RX buffers are full, the one which filled first is taken (see mcp2515_can_message_read_ordered).
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rt the RX thread.
+ * @return zero if a frame was moved or dropped, 1 if it was held because the ring is full, otherwise -1, including
+ * when there was no frame.
+ */
+static int
+rx_thread_drain(pi_mcp2515_t *pi_mcp2515, struct mcp2515_rx_thread *rt)
+{
+	pi_mcp2515_can_rx_frame_t discard;
+	int res;
+
+	if (rt->head - rt->tail_cache > rt->mask)
+		rt->tail_cache = __atomic_load_n(&rt->tail, __ATOMIC_ACQUIRE);
+
+	if (rt->head - rt->tail_cache > rt->mask) {
+		if (rt->overflow == PI_MCP2515_RX_OVERFLOW_HOLD) {
+			res = 1;
+			goto end;
+		}
+		memset(&discard, 0, sizeof(discard));
+		if (!(res = mcp2515_can_message_read_ordered(pi_mcp2515, &discard)))
+			__atomic_add_fetch(&rt->stats.dropped, 1, __ATOMIC_RELAXED);
+		else
+			res = -1;
+		goto end;
+	}
+
+	memset(&rt->frames[rt->head & rt->mask], 0, sizeof(pi_mcp2515_can_rx_frame_t));
+	if (mcp2515_can_message_read_ordered(pi_mcp2515, &rt->frames[rt->head & rt->mask])) {
+		res = -1;
+		goto end;
+	}
+	res = 0;
+
+	__atomic_store_n(&rt->head, rt->head + 1, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&rt->stats.received, 1, __ATOMIC_RELAXED);
+
+	/* Pairs with the fence in rx_thread_wait, so either the consumer sees the new head, or this sees it waiting. */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&rt->waiting, __ATOMIC_RELAXED)) {
+		pthread_mutex_lock(&rt->wait_lock);
+		pthread_cond_signal(&rt->wait_cond);
+		pthread_mutex_unlock(&rt->wait_lock);
+	}
+
+end:
+	return (res);
+}
+
+static void *
+rx_thread_main(void *arg)
+{
+	pi_mcp2515_t *pi_mcp2515 = arg;
+	struct mcp2515_rx_thread *rt = pi_mcp2515->rx_thread;
+	uint8_t flags[2], ovr, n; /* CANINTF and EFLG */
+	int res, held;
+
+	while (!__atomic_load_n(&rt->stop, __ATOMIC_ACQUIRE)) {
+		if (mcp2515_int_wait(pi_mcp2515, RX_THREAD_WAKE_MS) <= 0)
+			continue;
+		if (mcp2515_register_read(pi_mcp2515, flags, sizeof(flags), PI_MCP2515_RGSTR_CANINTF))
+			continue;
+		mcp2515_stats_eflg(pi_mcp2515, flags[1]);
+
+		if ((ovr = flags[1] & (PI_MCP2515_EFLG_RX0OVR | PI_MCP2515_EFLG_RX1OVR))) {
+			__atomic_add_fetch(&rt->stats.overruns, (ovr & PI_MCP2515_EFLG_RX0OVR ? 1 : 0)
+			    + (ovr & PI_MCP2515_EFLG_RX1OVR ? 1 : 0), __ATOMIC_RELAXED);
+			mcp2515_register_bitmod(pi_mcp2515, 0, ovr, PI_MCP2515_RGSTR_EFLG);
+		}
+
+		/* As many frames as there are RX buffers flagged full, each taken in the order they arrived. */
+		held = 0;
+		for (n = __builtin_popcount(flags[0] & (PI_MCP2515_CANINTF_RX0 | PI_MCP2515_CANINTF_RX1)); n > 0; n--) {
+			if ((res = rx_thread_drain(pi_mcp2515, rt))) {
+				held = res == 1;
+				break;
+			}
+		}
+
+		/* INT stays asserted while frames are held, or for any other interrupts the application has enabled, so
+		 * back off rather than spinning on it.
+		 */
+		if (held || !(flags[0] & (PI_MCP2515_CANINTF_RX0 | PI_MCP2515_CANINTF_RX1)))
+			mcp2515_micro_sleep(MCP2515_INT_POLL_USEC);
+	}
+
+	return (NULL);
+}
+
+/**
+ * @brief Wait for the ring to have a frame in it.
+ *
+ * @param rt the RX thread.
+ * @param timeout_ms how long to wait in milliseconds, zero to not wait at all, or negative to wait indefinitely.
+ * @return zero if there is a frame at the tail of the ring, otherwise 1.
+ */
+static int
+rx_thread_wait(struct mcp2515_rx_thread *rt, int timeout_ms)
+{
+	struct timespec deadline;
+	int res = 0;
+
+	if (rt->tail == rt->head_cache)
+		rt->head_cache = __atomic_load_n(&rt->head, __ATOMIC_ACQUIRE);
+
+	if (rt->tail == rt->head_cache && timeout_ms != 0) {
+		if (timeout_ms > 0) {
+			clock_gettime(CLOCK_MONOTONIC, &deadline);
+			deadline.tv_sec += timeout_ms / 1000;
+			deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+			if (deadline.tv_nsec >= 1000000000L) {
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000L;
+			}
+		}
+
+		pthread_mutex_lock(&rt->wait_lock);
+		__atomic_store_n(&rt->waiting, true, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		while (res == 0 && rt->tail == (rt->head_cache = __atomic_load_n(&rt->head, __ATOMIC_ACQUIRE))) {
+			if (timeout_ms > 0)
+				res = pthread_cond_timedwait(&rt->wait_cond, &rt->wait_lock, &deadline) == ETIMEDOUT;
+			else
+				pthread_cond_wait(&rt->wait_cond, &rt->wait_lock);
+		}
+		__atomic_store_n(&rt->waiting, false, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&rt->wait_lock);
+	}
+
+	return (rt->tail == rt->head_cache ? 1 : 0);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_rx_thread_functions RX Thread Functions
+ * @brief These functions handle receiving CAN bus messages on a background thread.
+ *
+ * While the RX thread is running, it is the only thing which should read the RX buffers. With an INT pin set up, it is
+ * also the only thing which should wait on it, so mcp2515_int_wait and mcp2515_int_fd must not be used. Other functions
+ * can still be used from the application as normal. These functions are not available on the Pico.
+ * @{
+ */
+/**
+ * @brief Start a thread which moves received CAN bus messages into a ring as soon as they arrive.
+ *
+ * Each message is kept with where and when it was received, which mcp2515_rx_thread_read_rx returns along with it.
+ *
+ * The RX buffer full interrupts are enabled. Set up the INT pin with mcp2515_int_init first, otherwise the thread
+ * polls the MCP2515 over SPI instead.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param ring_size how many frames the ring holds, which is rounded up to a power of two.
+ * @param overflow what to do with received frames when the ring is full.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_rx_thread_start(pi_mcp2515_t *pi_mcp2515, uint32_t ring_size, mcp2515_rx_overflow_t overflow)
+{
+	struct mcp2515_rx_thread *rt;
+	pthread_condattr_t attr;
+	uint32_t size = 1;
+	int res = -1;
+
+	if (pi_mcp2515->rx_thread != NULL || ring_size == 0 || ring_size > RX_THREAD_RING_MAX)
+		goto end;
+	while (size < ring_size)
+		size <<= 1;
+
+	if (posix_memalign((void **)&rt, RX_THREAD_CACHE_LINE, sizeof(*rt)))
+		goto end;
+	memset(rt, 0, sizeof(*rt));
+	if ((rt->frames = calloc(size, sizeof(pi_mcp2515_can_rx_frame_t))) == NULL)
+		goto err_rt;
+	rt->mask = size - 1;
+	rt->overflow = overflow;
+
+	if (pthread_mutex_init(&rt->wait_lock, NULL))
+		goto err_frames;
+	/* Timed reads wait on the monotonic clock, so aren't thrown out by the wall clock being changed. */
+	if (pthread_condattr_init(&attr))
+		goto err_lock;
+	if (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) || pthread_cond_init(&rt->wait_cond, &attr)) {
+		pthread_condattr_destroy(&attr);
+		goto err_lock;
+	}
+	pthread_condattr_destroy(&attr);
+
+	if ((res = mcp2515_register_bitmod(pi_mcp2515, PI_MCP2515_CANINTE_RX0IE | PI_MCP2515_CANINTE_RX1IE,
+	    PI_MCP2515_CANINTE_RX0IE | PI_MCP2515_CANINTE_RX1IE, PI_MCP2515_RGSTR_CANINTE)))
+		goto err_cond;
+
+	pi_mcp2515->rx_thread = rt;
+	if ((res = pthread_create(&rt->thread, NULL, rx_thread_main, pi_mcp2515))) {
+		pi_mcp2515->rx_thread = NULL;
+		goto err_cond;
+	}
+
+	goto end;
+
+err_cond:
+	pthread_cond_destroy(&rt->wait_cond);
+err_lock:
+	pthread_mutex_destroy(&rt->wait_lock);
+err_frames:
+	free(rt->frames);
+err_rt:
+	free(rt);
+	res = -1;
+end:
+	return (res);
+}
+
+/**
+ * @brief Stop the RX thread, discarding anything left in the ring.
+ *
+ * This is a NOOP if the RX thread isn't running. It is also done automatically by mcp2515_free.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_rx_thread_stop(pi_mcp2515_t *pi_mcp2515)
+{
+	struct mcp2515_rx_thread *rt = pi_mcp2515->rx_thread;
+
+	if (rt == NULL)
+		return;
+
+	__atomic_store_n(&rt->stop, true, __ATOMIC_RELEASE);
+	pthread_join(rt->thread, NULL);
+	pi_mcp2515->rx_thread = NULL;
+
+	pthread_cond_destroy(&rt->wait_cond);
+	pthread_mutex_destroy(&rt->wait_lock);
+	free(rt->frames);
+	free(rt);
+}
+
+/**
+ * @brief Take the next received CAN bus message from the RX thread's ring.
+ *
+ * This doesn't involve any SPI traffic. Only one thread may read from the ring.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param can_frame a pointer to the structure to store the received CAN bus frame.
+ * @param timeout_ms how long to wait for a message in milliseconds, zero to not wait at all, or negative to wait
+ *                   indefinitely.
+ * @return zero if success, 1 if there was no message in time, or -1 if the RX thread isn't running.
+ */
+int
+mcp2515_rx_thread_read(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_frame_t *can_frame, int timeout_ms)
+{
+	struct mcp2515_rx_thread *rt = pi_mcp2515->rx_thread;
+	int res = -1;
+
+	if (rt == NULL || (res = rx_thread_wait(rt, timeout_ms)))
+		goto end;
+
+	memcpy(can_frame, &rt->frames[rt->tail & rt->mask].frame, sizeof(*can_frame));
+	__atomic_store_n(&rt->tail, rt->tail + 1, __ATOMIC_RELEASE);
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Take the next received CAN bus message from the RX thread's ring, with where and when it was received.
+ *
+ * The frame is timestamped as by mcp2515_can_message_read_rx, when the RX thread read it. Otherwise, this is the same
+ * as mcp2515_rx_thread_read.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param rx_frame a pointer to the structure to store the received CAN bus frame and where it was received.
+ * @param timeout_ms how long to wait for a message in milliseconds, zero to not wait at all, or negative to wait
+ *                   indefinitely.
+ * @return zero if success, 1 if there was no message in time, or -1 if the RX thread isn't running.
+ */
+int
+mcp2515_rx_thread_read_rx(pi_mcp2515_t *pi_mcp2515, pi_mcp2515_can_rx_frame_t *rx_frame, int timeout_ms)
+{
+	struct mcp2515_rx_thread *rt = pi_mcp2515->rx_thread;
+	int res = -1;
+
+	if (rt == NULL || (res = rx_thread_wait(rt, timeout_ms)))
+		goto end;
+
+	memcpy(rx_frame, &rt->frames[rt->tail & rt->mask], sizeof(*rx_frame));
+	__atomic_store_n(&rt->tail, rt->tail + 1, __ATOMIC_RELEASE);
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Get the RX thread's counters.
+ *
+ * The counters are zeroed if the RX thread isn't running.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param stats where to put the counters.
+ */
+void
+mcp2515_rx_thread_stats(const pi_mcp2515_t *pi_mcp2515, pi_mcp2515_rx_thread_stats_t *stats)
+{
+	const struct mcp2515_rx_thread *rt = pi_mcp2515->rx_thread;
+
+	memset(stats, 0, sizeof(*stats));
+	if (rt == NULL)
+		return;
+
+	stats->received = __atomic_load_n(&rt->stats.received, __ATOMIC_RELAXED);
+	stats->dropped = __atomic_load_n(&rt->stats.dropped, __ATOMIC_RELAXED);
+	stats->overruns = __atomic_load_n(&rt->stats.overruns, __ATOMIC_RELAXED);
+}
+/** @} */
+
+#endif /* USE_SPI */
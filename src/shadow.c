@@ -0,0 +1,224 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The register shadow keeps a copy of the configuration registers, which only change when written over SPI, so reading
+ * them back can skip the SPI transaction.
+ *
+ * CANCTRL, CANINTE, and BFPCTRL are written through to the shadow. The CNF registers and the filters and masks can only
+ * be written in configuration mode, and writes are silently ignored otherwise, so writing one of those drops it from
+ * the shadow until it is next read instead.
+ */
+
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define SHADOW_NONE 0
+#define SHADOW_WRITE_THROUGH 1
+#define SHADOW_CONFIG 2
+
+/* The shadowed registers all lie in one burst, from RXF0SIDH through to CANINTE. */
+#define SHADOW_LEN (PI_MCP2515_RGSTR_CANINTE + 1)
+
+#define SHADOW_VALID(pi, addr) ((pi)->shadow_valid[(addr) >> 3] & (1 << ((addr) & 0x07)))
+
+static uint8_t	shadow_class(uint8_t);
+
+static uint8_t
+shadow_class(uint8_t addr)
+{
+	if (addr == PI_MCP2515_RGSTR_CANCTRL || addr == PI_MCP2515_RGSTR_CANINTE || addr == PI_MCP2515_RGSTR_BFPCTRL)
+		return (SHADOW_WRITE_THROUGH);
+	if (addr < SHADOW_LEN && (addr & 0x0F) < PI_MCP2515_RGSTR_BFPCTRL)
+		return (SHADOW_CONFIG);
+
+	return (SHADOW_NONE);
+}
+
+/**
+ * @brief Check whether a run of registers can all be read from the shadow.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param len how many registers.
+ * @param rgstr the first register.
+ * @return true if every register is in the shadow.
+ */
+bool
+mcp2515_shadow_cached(const pi_mcp2515_t *pi_mcp2515, uint8_t len, uint8_t rgstr)
+{
+	uint8_t i;
+
+	if (!pi_mcp2515->shadow_enabled || len == 0 || (size_t)rgstr + len > SHADOW_LEN)
+		return (false);
+
+	for (i = rgstr; i < rgstr + len; i++)
+		if (shadow_class(i) == SHADOW_NONE || !SHADOW_VALID(pi_mcp2515, i))
+			return (false);
+
+	return (true);
+}
+
+/**
+ * @brief Read a run of registers from the shadow, which must all be there (see mcp2515_shadow_cached).
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param data where to put the register values.
+ * @param len how many registers.
+ * @param rgstr the first register.
+ */
+void
+mcp2515_shadow_get(const pi_mcp2515_t *pi_mcp2515, uint8_t *data, uint8_t len, uint8_t rgstr)
+{
+	memcpy(data, &pi_mcp2515->shadow[rgstr], len);
+}
+
+/**
+ * @brief Update the shadow after a run of registers has been read or written over SPI.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param instr PI_MCP2515_INSTR_READ or PI_MCP2515_INSTR_WRITE.
+ * @param data the register values read or written.
+ * @param len how many registers.
+ * @param rgstr the first register.
+ */
+void
+mcp2515_shadow_update(pi_mcp2515_t *pi_mcp2515, uint8_t instr, const uint8_t *data, uint8_t len, uint8_t rgstr)
+{
+	uint8_t class, addr, i;
+
+	if (!pi_mcp2515->shadow_enabled)
+		return;
+
+	for (i = 0; i < len; i++) {
+		addr = (rgstr + i) & (PI_MCP2515_REGISTER_SPACE_LEN - 1);
+		/* CANCTRL can be written at the end of every row of the register map. */
+		if (instr == PI_MCP2515_INSTR_WRITE && (addr & 0x0F) == 0x0F)
+			addr = PI_MCP2515_RGSTR_CANCTRL;
+		if ((class = shadow_class(addr)) == SHADOW_NONE)
+			continue;
+
+		if (instr == PI_MCP2515_INSTR_READ || class == SHADOW_WRITE_THROUGH) {
+			pi_mcp2515->shadow[addr] = data[i];
+			pi_mcp2515->shadow_valid[addr >> 3] |= 1 << (addr & 0x07);
+		} else
+			pi_mcp2515->shadow_valid[addr >> 3] &= ~(1 << (addr & 0x07));
+	}
+}
+
+/**
+ * @brief Update the shadow after a register has been changed with a BIT MODIFY over SPI.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param data the new bit values.
+ * @param mask which bits were changed.
+ * @param rgstr the register.
+ */
+void
+mcp2515_shadow_bitmod(pi_mcp2515_t *pi_mcp2515, uint8_t data, uint8_t mask, uint8_t rgstr)
+{
+	uint8_t addr = (rgstr & 0x0F) == 0x0F ? PI_MCP2515_RGSTR_CANCTRL : rgstr;
+
+	if (!pi_mcp2515->shadow_enabled)
+		return;
+
+	switch (shadow_class(addr)) {
+	case SHADOW_WRITE_THROUGH:
+		pi_mcp2515->shadow[addr] = (pi_mcp2515->shadow[addr] & ~mask) | (data & mask);
+		break;
+	case SHADOW_CONFIG:
+		pi_mcp2515->shadow_valid[addr >> 3] &= ~(1 << (addr & 0x07));
+		break;
+	default:
+		break;
+	}
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_shadow_functions Register Shadow Functions
+ * @brief These functions handle the register shadow, which saves reading back configuration registers over SPI.
+ *
+ * The shadow covers CANCTRL, CANINTE, BFPCTRL, the CNF registers, and the acceptance filters and masks. Everything
+ * else, including status registers like CANSTAT, is always read from the MCP2515. The shadow is only kept up to date
+ * through this library, so anything else changing the MCP2515's configuration, such as a reset by another program,
+ * calls for mcp2515_shadow_invalidate or mcp2515_shadow_verify.
+ * @{
+ */
+/**
+ * @brief Enable or disable the register shadow.
+ *
+ * The shadow starts out empty, and fills as registers are read and written. mcp2515_shadow_verify fills it all at once.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param enable whether to use the shadow.
+ */
+void
+mcp2515_shadow_enable(pi_mcp2515_t *pi_mcp2515, bool enable)
+{
+	mcp2515_shadow_invalidate(pi_mcp2515);
+	pi_mcp2515->shadow_enabled = enable;
+}
+
+/**
+ * @brief Empty the register shadow, so the next read of each register goes to the MCP2515.
+ *
+ * This is done automatically by mcp2515_reset.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_shadow_invalidate(pi_mcp2515_t *pi_mcp2515)
+{
+	memset(pi_mcp2515->shadow_valid, 0, sizeof(pi_mcp2515->shadow_valid));
+}
+
+/**
+ * @brief Check the register shadow against the MCP2515, and refill it.
+ *
+ * This reads all the shadowed registers in a single SPI transaction.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return zero if the shadow matched, 1 if it didn't, otherwise -1 if the shadow isn't enabled or on error.
+ */
+int
+mcp2515_shadow_verify(pi_mcp2515_t *pi_mcp2515)
+{
+	uint8_t message[2] = { PI_MCP2515_INSTR_READ, PI_MCP2515_RGSTR_RXF0SIDH }, regs[SHADOW_LEN], i;
+	pi_mcp2515_spi_seg_t segs[2] = {
+		{ .tx = message, .len = sizeof(message) },
+		{ .rx = regs, .len = sizeof(regs), .cs_change = true },
+	};
+	int res = -1;
+
+	if (!pi_mcp2515->shadow_enabled || mcp2515_spi_transfer(pi_mcp2515, segs, 2))
+		goto err;
+
+	res = 0;
+	for (i = 0; i < SHADOW_LEN; i++) {
+		if (shadow_class(i) != SHADOW_NONE && SHADOW_VALID(pi_mcp2515, i) && pi_mcp2515->shadow[i] != regs[i]) {
+			MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_SHADOW, i, pi_mcp2515->shadow[i], regs[i]);
+			res = 1;
+		}
+	}
+	mcp2515_shadow_update(pi_mcp2515, PI_MCP2515_INSTR_READ, regs, SHADOW_LEN, PI_MCP2515_RGSTR_RXF0SIDH);
+
+err:
+	return (res);
+}
+/** @} */
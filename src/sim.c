@@ -0,0 +1,511 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* A simulated MCP2515, plugged in as a transport in place of the SPI hardware.
+ *
+ * This models the register file and the SPI instruction set closely enough to run the library against without any
+ * hardware, for instance to benchmark the library's own overhead on a machine with no SPI bus. Transmission is
+ * instantaneous and always succeeds. In loopback mode, transmitted frames are received back through the acceptance
+ * filters as they would be on the real device, and in normal or listen-only mode frames can be injected as though
+ * they arrived from the bus with mcp2515_sim_inject. Timing, bit errors, and error counters are not modelled.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define SIM_SIDL_EXIDE 0x08
+
+#define SIM_TXB_CTRL(n) (PI_MCP2515_RGSTR_TXB0CTRL + ((n) << 4))
+#define SIM_RXB_CTRL(n) (PI_MCP2515_RGSTR_RXB0CTRL + ((n) << 4))
+#define SIM_OPMOD(sim) ((sim)->regs[PI_MCP2515_RGSTR_CANSTAT] & PI_MCP2515_REQOP_MASK)
+
+struct mcp2515_sim {
+	uint8_t regs[PI_MCP2515_REGISTER_SPACE_LEN];
+};
+
+static void	sim_free(pi_mcp2515_t *);
+static int	sim_transfer(pi_mcp2515_t *, const pi_mcp2515_spi_seg_t *, uint8_t);
+
+static const pi_mcp2515_transport_t sim_transport = {
+	.transfer = sim_transfer,
+	.free = sim_free,
+};
+
+static void
+sim_reset(struct mcp2515_sim *sim)
+{
+	memset(sim->regs, 0, sizeof(sim->regs));
+	sim->regs[PI_MCP2515_RGSTR_CANCTRL] = 0x87;
+	sim->regs[PI_MCP2515_RGSTR_CANSTAT] = PI_MCP2515_REQOP_CONFIG;
+}
+
+static uint8_t
+sim_read(const struct mcp2515_sim *sim, uint8_t addr)
+{
+	addr &= PI_MCP2515_REGISTER_SPACE_LEN - 1;
+
+	/* CANSTAT and CANCTRL are mirrored at the end of every row of the register map. */
+	if ((addr & 0x0F) == 0x0E)
+		addr = PI_MCP2515_RGSTR_CANSTAT;
+	else if ((addr & 0x0F) == 0x0F)
+		addr = PI_MCP2515_RGSTR_CANCTRL;
+
+	return (sim->regs[addr]);
+}
+
+/**
+ * @brief Check a frame against one acceptance filter.
+ *
+ * For standard frames, the mask and filter EID bits are applied to the first two data bytes.
+ *
+ * @param sim the simulated MCP2515.
+ * @param frame the frame, laid out as in the TX buffer registers.
+ * @param filter the first register of the filter.
+ * @param mask the first register of the mask.
+ * @return true if the frame passes the filter.
+ */
+static bool
+sim_filter_match(const struct mcp2515_sim *sim, const uint8_t *frame, uint8_t filter, uint8_t mask)
+{
+	const uint8_t *f = &sim->regs[filter], *m = &sim->regs[mask];
+	bool ext = !!(frame[1] & SIM_SIDL_EXIDE);
+
+	if (ext != !!(f[1] & SIM_SIDL_EXIDE))
+		return (false);
+	if ((frame[0] ^ f[0]) & m[0])
+		return (false);
+	if ((frame[1] ^ f[1]) & m[1] & (ext ? 0xE3 : 0xE0))
+		return (false);
+	if (ext)
+		return (!((frame[2] ^ f[2]) & m[2]) && !((frame[3] ^ f[3]) & m[3]));
+
+	return (!((frame[5] ^ f[2]) & m[2]) && !((frame[6] ^ f[3]) & m[3]));
+}
+
+/**
+ * @brief Check a frame against the mask and filters of an RX buffer.
+ *
+ * @param sim the simulated MCP2515.
+ * @param frame the frame, laid out as in the TX buffer registers.
+ * @param rxb the RX buffer.
+ * @param filhit set to the index of the filter that matched.
+ * @return true if the frame is accepted.
+ */
+static bool
+sim_rxb_accepts(const struct mcp2515_sim *sim, const uint8_t *frame, uint8_t rxb, uint8_t *filhit)
+{
+	static const uint8_t filters[] = {
+		PI_MCP2515_RGSTR_RXF0SIDH, PI_MCP2515_RGSTR_RXF1SIDH, PI_MCP2515_RGSTR_RXF2SIDH,
+		PI_MCP2515_RGSTR_RXF3SIDH, PI_MCP2515_RGSTR_RXF4SIDH, PI_MCP2515_RGSTR_RXF5SIDH
+	};
+	uint8_t i, first = rxb == 0 ? 0 : 2, last = rxb == 0 ? 2 : 6;
+
+	if ((sim->regs[SIM_RXB_CTRL(rxb)] & PI_MCP2515_RXBCTRL_STDEXT_MASK) == PI_MCP2515_RXBCTRL_STDEXT_MASK) {
+		*filhit = first;
+		return (true);
+	}
+
+	for (i = first; i < last; i++) {
+		if (sim_filter_match(sim, frame, filters[i],
+		    rxb == 0 ? PI_MCP2515_RGSTR_RXM0SIDH : PI_MCP2515_RGSTR_RXM1SIDH)) {
+			*filhit = i;
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+/**
+ * @brief Receive a frame as though it came off the bus.
+ *
+ * RXB0 takes priority. A frame accepted by RXB0 while it is full rolls over into RXB1 if BUKT is set, and otherwise
+ * overflows.
+ *
+ * @param sim the simulated MCP2515.
+ * @param frame the frame, laid out as in the TX buffer registers.
+ */
+static void
+sim_receive(struct mcp2515_sim *sim, const uint8_t *frame)
+{
+	uint8_t *intf = &sim->regs[PI_MCP2515_RGSTR_CANINTF], *ctrl, rx[MCP2515_FRAME_LEN], filhit, overflow = 0;
+	bool ext = !!(frame[1] & SIM_SIDL_EXIDE), rtr = !!(frame[4] & PI_MCP2515_CAN_DLC_RTR_FLAG);
+	int rxb = -1;
+
+	if (sim_rxb_accepts(sim, frame, 0, &filhit)) {
+		if (!(*intf & PI_MCP2515_CANINTF_RX0))
+			rxb = 0;
+		else if (!(sim->regs[SIM_RXB_CTRL(0)] & PI_MCP2515_RXB0CTRL_BUKT))
+			overflow = PI_MCP2515_EFLG_RX0OVR;
+		else if (!(*intf & PI_MCP2515_CANINTF_RX1))
+			rxb = 1;
+		else
+			overflow = PI_MCP2515_EFLG_RX1OVR;
+	} else if (sim_rxb_accepts(sim, frame, 1, &filhit)) {
+		if (!(*intf & PI_MCP2515_CANINTF_RX1))
+			rxb = 1;
+		else
+			overflow = PI_MCP2515_EFLG_RX1OVR;
+	}
+
+	if (overflow) {
+		sim->regs[PI_MCP2515_RGSTR_EFLG] |= overflow;
+		*intf |= PI_MCP2515_CANINTF_ERRIF;
+	}
+	if (rxb < 0)
+		return;
+
+	/* The RX buffers differ from the TX buffers in how remote frames are flagged. */
+	memcpy(rx, frame, sizeof(rx));
+	rx[1] = frame[1] & (ext ? 0xEB : 0xE0);
+	if (!ext && rtr)
+		rx[1] |= PI_MCP2515_RXBSIDL_SRR;
+	rx[4] = frame[4] & (ext ? (PI_MCP2515_CAN_DLC_RTR_FLAG | PI_MCP2515_CAN_DLC_RTR_MASK)
+	    : PI_MCP2515_CAN_DLC_RTR_MASK);
+	memcpy(&sim->regs[SIM_RXB_CTRL(rxb) + 1], rx, sizeof(rx));
+
+	ctrl = &sim->regs[SIM_RXB_CTRL(rxb)];
+	*ctrl &= ~(PI_MCP2515_RXBCTRL_RXRTR | (rxb == 0 ? PI_MCP2515_RXB0CTRL_FILHIT : PI_MCP2515_RXB1CTRL_FILHIT));
+	*ctrl |= (rtr ? PI_MCP2515_RXBCTRL_RXRTR : 0) | filhit;
+	*intf |= rxb == 0 ? PI_MCP2515_CANINTF_RX0 : PI_MCP2515_CANINTF_RX1;
+}
+
+/**
+ * @brief Transmit any TX buffers with TXREQ set, if the operating mode allows.
+ *
+ * Buffers go in TXP priority order, with the higher buffer number going first between equal priorities, as on the
+ * real device.
+ *
+ * @param sim the simulated MCP2515.
+ */
+static void
+sim_transmit(struct mcp2515_sim *sim)
+{
+	uint8_t opmod = SIM_OPMOD(sim), *ctrl;
+	int i, next;
+
+	if (opmod != PI_MCP2515_REQOP_NORMAL && opmod != PI_MCP2515_REQOP_LOOPBACK)
+		return;
+
+	for (;;) {
+		next = -1;
+		for (i = 2; i >= 0; i--) {
+			ctrl = &sim->regs[SIM_TXB_CTRL(i)];
+			if ((*ctrl & PI_MCP2515_CTRL_TXREQ) && (next < 0 || (*ctrl & PI_MCP2515_CTRL_TXP_MASK)
+			    > (sim->regs[SIM_TXB_CTRL(next)] & PI_MCP2515_CTRL_TXP_MASK)))
+				next = i;
+		}
+		if (next < 0)
+			break;
+
+		if (opmod == PI_MCP2515_REQOP_LOOPBACK)
+			sim_receive(sim, &sim->regs[SIM_TXB_CTRL(next) + 1]);
+
+		sim->regs[SIM_TXB_CTRL(next)] &= ~(PI_MCP2515_CTRL_TXREQ | PI_MCP2515_CTRL_TXERR | PI_MCP2515_CTRL_MLOA
+		    | PI_MCP2515_CTRL_ABTF);
+		sim->regs[PI_MCP2515_RGSTR_CANINTF] |= PI_MCP2515_CANINTF_TX0IF << next;
+	}
+}
+
+static void
+sim_write(struct mcp2515_sim *sim, uint8_t addr, uint8_t value)
+{
+	uint8_t *reg, old;
+
+	addr &= PI_MCP2515_REGISTER_SPACE_LEN - 1;
+
+	if ((addr & 0x0F) == 0x0E)
+		return; /* CANSTAT is read-only. */
+
+	if ((addr & 0x0F) == 0x0F) {
+		/* Mode changes take effect immediately. */
+		sim->regs[PI_MCP2515_RGSTR_CANCTRL] = value;
+		sim->regs[PI_MCP2515_RGSTR_CANSTAT] = (sim->regs[PI_MCP2515_RGSTR_CANSTAT] & ~PI_MCP2515_REQOP_MASK)
+		    | (value & PI_MCP2515_REQOP_MASK);
+		sim_transmit(sim);
+		return;
+	}
+
+	/* Filters, masks, and the CNF registers can only be written in config mode. */
+	if (addr <= PI_MCP2515_RGSTR_CNF1 && (addr & 0x0F) < 0x0C && SIM_OPMOD(sim) != PI_MCP2515_REQOP_CONFIG)
+		return;
+
+	reg = &sim->regs[addr];
+	old = *reg;
+
+	switch (addr) {
+	case PI_MCP2515_RGSTR_TXB0CTRL:
+	case PI_MCP2515_RGSTR_TXB1CTRL:
+	case PI_MCP2515_RGSTR_TXB2CTRL:
+		*reg = (old & ~(PI_MCP2515_CTRL_TXREQ | PI_MCP2515_CTRL_TXP_MASK))
+		    | (value & (PI_MCP2515_CTRL_TXREQ | PI_MCP2515_CTRL_TXP_MASK));
+		if (!(old & PI_MCP2515_CTRL_TXREQ) && (value & PI_MCP2515_CTRL_TXREQ)) {
+			*reg &= ~(PI_MCP2515_CTRL_TXERR | PI_MCP2515_CTRL_MLOA | PI_MCP2515_CTRL_ABTF);
+			sim_transmit(sim);
+		} else if ((old & PI_MCP2515_CTRL_TXREQ) && !(value & PI_MCP2515_CTRL_TXREQ))
+			*reg |= PI_MCP2515_CTRL_ABTF;
+		break;
+	case PI_MCP2515_RGSTR_RXB0CTRL:
+		*reg = (old & (PI_MCP2515_RXBCTRL_RXRTR | PI_MCP2515_RXB0CTRL_FILHIT))
+		    | (value & (PI_MCP2515_RXBCTRL_STDEXT_MASK | PI_MCP2515_RXB0CTRL_BUKT));
+		if (*reg & PI_MCP2515_RXB0CTRL_BUKT)
+			*reg |= PI_MCP2515_RXB0CTRL_BUKT1;
+		break;
+	case PI_MCP2515_RGSTR_RXB1CTRL:
+		*reg = (old & (PI_MCP2515_RXBCTRL_RXRTR | PI_MCP2515_RXB1CTRL_FILHIT))
+		    | (value & PI_MCP2515_RXBCTRL_STDEXT_MASK);
+		break;
+	case PI_MCP2515_RGSTR_EFLG:
+		/* Only the overflow flags can be changed. */
+		*reg = (old & ~(PI_MCP2515_EFLG_RX0OVR | PI_MCP2515_EFLG_RX1OVR))
+		    | (value & (PI_MCP2515_EFLG_RX0OVR | PI_MCP2515_EFLG_RX1OVR));
+		break;
+	default:
+		*reg = value;
+		break;
+	}
+}
+
+static uint8_t
+sim_status(const struct mcp2515_sim *sim)
+{
+	uint8_t intf = sim->regs[PI_MCP2515_RGSTR_CANINTF], res, i;
+
+	res = intf & (PI_MCP2515_STATUS_RX0BF | PI_MCP2515_STATUS_RX1BF);
+	for (i = 0; i < 3; i++) {
+		if (sim->regs[SIM_TXB_CTRL(i)] & PI_MCP2515_CTRL_TXREQ)
+			res |= PI_MCP2515_STATUS_TX0REQ << (i * 2);
+		if (intf & (PI_MCP2515_CANINTF_TX0IF << i))
+			res |= PI_MCP2515_STATUS_TX0IF << (i * 2);
+	}
+
+	return (res);
+}
+
+static uint8_t
+sim_rx_status(const struct mcp2515_sim *sim)
+{
+	uint8_t intf = sim->regs[PI_MCP2515_RGSTR_CANINTF], res, ctrl, filhit;
+	int rxb;
+
+	res = (intf & (PI_MCP2515_CANINTF_RX0 | PI_MCP2515_CANINTF_RX1)) << 6;
+	if (intf & PI_MCP2515_CANINTF_RX0)
+		rxb = 0;
+	else if (intf & PI_MCP2515_CANINTF_RX1)
+		rxb = 1;
+	else
+		return (res);
+
+	/* The type and filter bits describe RXB0 if it is full, else RXB1. */
+	ctrl = sim->regs[SIM_RXB_CTRL(rxb)];
+	if (sim->regs[SIM_RXB_CTRL(rxb) + 2] & SIM_SIDL_EXIDE)
+		res |= PI_MCP2515_RX_STATUS_EID;
+	if (ctrl & PI_MCP2515_RXBCTRL_RXRTR)
+		res |= PI_MCP2515_RX_STATUS_RTR;
+
+	if (rxb == 0)
+		filhit = ctrl & PI_MCP2515_RXB0CTRL_FILHIT;
+	else if ((filhit = ctrl & PI_MCP2515_RXB1CTRL_FILHIT) < 2)
+		filhit += 6; /* RXF0 or RXF1, rolled over into RXB1. */
+
+	return (res | filhit);
+}
+
+/**
+ * @brief Carry out a single SPI command, from chip select going low to it going high again.
+ *
+ * @param sim the simulated MCP2515.
+ * @param tx the bytes clocked in to the MCP2515.
+ * @param rx where to put the bytes clocked out of the MCP2515.
+ * @param len the length of the command.
+ */
+static void
+sim_command(struct mcp2515_sim *sim, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+	size_t i;
+	uint8_t addr, instr = tx[0], n;
+
+	memset(rx, 0, len);
+
+	switch (instr) {
+	case PI_MCP2515_INSTR_RESET:
+		sim_reset(sim);
+		return;
+	case PI_MCP2515_INSTR_READ:
+		for (i = 2, addr = tx[1]; i < len; i++, addr++)
+			rx[i] = sim_read(sim, addr);
+		return;
+	case PI_MCP2515_INSTR_WRITE:
+		for (i = 2, addr = tx[1]; i < len; i++, addr++)
+			sim_write(sim, addr, tx[i]);
+		return;
+	case PI_MCP2515_INSTR_BITMOD:
+		if (len >= 4)
+			sim_write(sim, tx[1], (sim_read(sim, tx[1]) & ~tx[2]) | (tx[3] & tx[2]));
+		return;
+	case PI_MCP2515_INSTR_READ_STATUS:
+		for (i = 1; i < len; i++)
+			rx[i] = sim_status(sim);
+		return;
+	case PI_MCP2515_INSTR_RX_STATUS:
+		for (i = 1; i < len; i++)
+			rx[i] = sim_rx_status(sim);
+		return;
+	default:
+		break;
+	}
+
+	if ((instr & 0xF8) == PI_MCP2515_INSTR_LOAD_TX0 && (instr & 0x07) <= 5) {
+		/* LOAD TX BUFFER: bits 2-1 select the buffer, and bit 0 starts at D0 rather than SIDH. */
+		n = (instr >> 1) & 0x03;
+		addr = SIM_TXB_CTRL(n) + ((instr & 0x01) ? 6 : 1);
+		for (i = 1; i < len; i++, addr++)
+			sim_write(sim, addr, tx[i]);
+	} else if ((instr & 0xF9) == PI_MCP2515_INSTR_READ_RX0) {
+		/* READ RX BUFFER: bit 2 selects the buffer, and bit 1 starts at D0 rather than SIDH. */
+		n = (instr >> 2) & 0x01;
+		addr = SIM_RXB_CTRL(n) + ((instr & 0x02) ? 6 : 1);
+		for (i = 1; i < len; i++, addr++)
+			rx[i] = sim_read(sim, addr);
+		sim->regs[PI_MCP2515_RGSTR_CANINTF] &= ~(PI_MCP2515_CANINTF_RX0 << n);
+	} else if ((instr & 0xF8) == PI_MCP2515_INSTR_RTS) {
+		/* RTS, for any combination of the three TX buffers. */
+		for (n = 0; n < 3; n++) {
+			if (instr & (1 << n)) {
+				sim->regs[SIM_TXB_CTRL(n)] |= PI_MCP2515_CTRL_TXREQ;
+				sim->regs[SIM_TXB_CTRL(n)] &= ~(PI_MCP2515_CTRL_TXERR | PI_MCP2515_CTRL_MLOA
+				    | PI_MCP2515_CTRL_ABTF);
+			}
+		}
+		sim_transmit(sim);
+	}
+}
+
+static int
+sim_transfer(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_spi_seg_t *segs, uint8_t n)
+{
+	struct mcp2515_sim *sim = pi_mcp2515->transport_ctx;
+	uint8_t tx[MCP2515_SPI_BURST_MAX], rx[MCP2515_SPI_BURST_MAX], i, start = 0, j;
+	size_t len = 0, off;
+	int res = 0;
+
+	for (i = 0; i < n; i++) {
+		if (len + segs[i].len > sizeof(tx)) {
+			res = -1;
+			goto err;
+		}
+		if (segs[i].tx != NULL)
+			memcpy(&tx[len], segs[i].tx, segs[i].len);
+		else
+			memset(&tx[len], 0, segs[i].len);
+		len += segs[i].len;
+
+		if (!segs[i].cs_change && i + 1 < n)
+			continue;
+
+		if (len > 0)
+			sim_command(sim, tx, rx, len);
+
+		for (j = start, off = 0; j <= i; off += segs[j].len, j++)
+			if (segs[j].rx != NULL)
+				memcpy(segs[j].rx, &rx[off], segs[j].len);
+
+		start = i + 1;
+		len = 0;
+	}
+
+err:
+	return (res);
+}
+
+static void
+sim_free(pi_mcp2515_t *pi_mcp2515)
+{
+	free(pi_mcp2515->transport_ctx);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_sim_functions Simulation Functions
+ * @brief These functions handle the simulated MCP2515.
+ * @{
+ */
+/**
+ * @brief Set up a pi_mcp2515_t structure backed by a simulated MCP2515 instead of SPI hardware.
+ *
+ * The simulated MCP2515 starts out as it would after a reset, in config mode.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param osc_mhz the frequency of the simulated MCP2515 oscillator in MHz.
+ * @return zero if success, otherwise non-zero
+ */
+int
+mcp2515_init_sim(pi_mcp2515_t **pi_mcp2515, uint8_t osc_mhz)
+{
+	struct mcp2515_sim *sim;
+	int res;
+
+	if ((sim = calloc(1, sizeof(*sim))) == NULL) {
+		res = -1;
+		goto err;
+	}
+	sim_reset(sim);
+
+	if ((res = mcp2515_init_transport(pi_mcp2515, &sim_transport, sim, osc_mhz)))
+		free(sim);
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Deliver a frame to a simulated MCP2515 as though it were received from the bus.
+ *
+ * The frame is put through the acceptance filters as it would be on the real device. It is ignored unless in normal or
+ * listen-only mode.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle, which must have been set up with mcp2515_init_sim.
+ * @param can_frame the CAN bus frame to deliver.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_sim_inject(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_can_frame_t *can_frame)
+{
+	struct mcp2515_sim *sim;
+	uint8_t frame[MCP2515_FRAME_LEN] = { 0 }, opmod;
+	int res = -1;
+
+	if (pi_mcp2515->transport != &sim_transport)
+		goto err;
+
+	sim = pi_mcp2515->transport_ctx;
+	opmod = SIM_OPMOD(sim);
+	if (opmod != PI_MCP2515_REQOP_NORMAL && opmod != PI_MCP2515_REQOP_LISTENONLY)
+		goto err;
+
+	mcp2515_can_frame_encode(can_frame, frame);
+	sim_receive(sim, frame);
+	res = 0;
+
+err:
+	return (res);
+}
+/** @} */
@@ -0,0 +1,123 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Runtime counters for a handle. They are bumped on the data path with relaxed atomic adds (see MCP2515_STAT_ADD),
+ * so nothing here takes the transport lock, and a snapshot may be a few counts out between fields.
+ */
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define STATS_EFLG_OVR (PI_MCP2515_EFLG_RX0OVR | PI_MCP2515_EFLG_RX1OVR)
+
+/* Count the overrun and bus-off flags in a value read from EFLG which weren't already set the last time it was read. */
+void
+mcp2515_stats_eflg(pi_mcp2515_t *pi_mcp2515, uint8_t eflg)
+{
+	uint8_t fresh;
+
+	eflg &= STATS_EFLG_OVR | PI_MCP2515_EFLG_TXBO;
+#ifdef USE_PICO_LIB
+	fresh = eflg & ~pi_mcp2515->stats_eflg;
+	pi_mcp2515->stats_eflg = eflg;
+#else
+	fresh = eflg & ~__atomic_exchange_n(&pi_mcp2515->stats_eflg, eflg, __ATOMIC_RELAXED);
+#endif /* USE_PICO_LIB */
+
+	if (fresh)
+		MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_EFLG, eflg);
+	if (fresh & STATS_EFLG_OVR)
+		MCP2515_STAT_ADD(pi_mcp2515, rx_overruns, (fresh & PI_MCP2515_EFLG_RX0OVR ? 1 : 0)
+		    + (fresh & PI_MCP2515_EFLG_RX1OVR ? 1 : 0));
+	if (fresh & PI_MCP2515_EFLG_TXBO)
+		MCP2515_STAT_ADD(pi_mcp2515, bus_off, 1);
+}
+
+/* Forget EFLG bits which have just been cleared, so they are counted again when next set. */
+void
+mcp2515_stats_eflg_clear(pi_mcp2515_t *pi_mcp2515, uint8_t bits)
+{
+	/* Only the overflow flags can be cleared over SPI. */
+	bits &= STATS_EFLG_OVR;
+#ifdef USE_PICO_LIB
+	pi_mcp2515->stats_eflg &= ~bits;
+#else
+	__atomic_and_fetch(&pi_mcp2515->stats_eflg, (uint8_t)~bits, __ATOMIC_RELAXED);
+#endif /* USE_PICO_LIB */
+}
+
+/* Forget the EFLG bits cleared by a write, if the registers written include EFLG. */
+void
+mcp2515_stats_eflg_write(pi_mcp2515_t *pi_mcp2515, const uint8_t *values, uint8_t len, uint8_t rgstr)
+{
+	if (rgstr <= PI_MCP2515_RGSTR_EFLG && rgstr + len > PI_MCP2515_RGSTR_EFLG)
+		mcp2515_stats_eflg_clear(pi_mcp2515, ~values[PI_MCP2515_RGSTR_EFLG - rgstr]);
+}
+
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_stats_functions Statistics Functions
+ * @brief These functions read the runtime counters kept for each handle.
+ *
+ * The counters are kept without locking, so reading them never holds up the data path, or is held up by it. Overruns
+ * and bus-off events are only seen when EFLG is read, by mcp2515_error_flags (or mcp2515_error) or the RX thread.
+ * @{
+ */
+/**
+ * @brief Take a snapshot of the handle's runtime counters.
+ *
+ * Each counter is read atomically, but not all of them at once, so they may be slightly out of step with each other
+ * while the handle is in use.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param stats where to put the counters.
+ */
+void
+mcp2515_stats_get(const pi_mcp2515_t *pi_mcp2515, pi_mcp2515_stats_t *stats)
+{
+	stats->spi_transactions = MCP2515_STAT_LOAD(pi_mcp2515, spi_transactions);
+	stats->spi_bytes = MCP2515_STAT_LOAD(pi_mcp2515, spi_bytes);
+	stats->syscalls = MCP2515_STAT_LOAD(pi_mcp2515, syscalls);
+	stats->frames_rx = MCP2515_STAT_LOAD(pi_mcp2515, frames_rx);
+	stats->frames_tx = MCP2515_STAT_LOAD(pi_mcp2515, frames_tx);
+	stats->rx_overruns = MCP2515_STAT_LOAD(pi_mcp2515, rx_overruns);
+	stats->tx_errors = MCP2515_STAT_LOAD(pi_mcp2515, tx_errors);
+	stats->bus_off = MCP2515_STAT_LOAD(pi_mcp2515, bus_off);
+}
+
+/**
+ * @brief Zero the handle's runtime counters.
+ *
+ * Counts made while this runs may or may not be kept.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_stats_reset(pi_mcp2515_t *pi_mcp2515)
+{
+	MCP2515_STAT_SET(pi_mcp2515, spi_transactions, 0);
+	MCP2515_STAT_SET(pi_mcp2515, spi_bytes, 0);
+	MCP2515_STAT_SET(pi_mcp2515, syscalls, 0);
+	MCP2515_STAT_SET(pi_mcp2515, frames_rx, 0);
+	MCP2515_STAT_SET(pi_mcp2515, frames_tx, 0);
+	MCP2515_STAT_SET(pi_mcp2515, rx_overruns, 0);
+	MCP2515_STAT_SET(pi_mcp2515, tx_errors, 0);
+	MCP2515_STAT_SET(pi_mcp2515, bus_off, 0);
+}
+/** @} */
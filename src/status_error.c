@@ -33,15 +33,41 @@
 uint8_t
 mcp2515_status(pi_mcp2515_t *pi_mcp2515)
 {
-	uint8_t instruction, res;
+	uint8_t instruction = PI_MCP2515_INSTR_READ_STATUS, res = 0;
+	pi_mcp2515_spi_seg_t segs[2] = {
+		{ .tx = &instruction, .len = 1 },
+		{ .rx = &res, .len = 1, .cs_change = true },
+	};
 
-	CS_LOW(pi_mcp2515);
-	instruction = PI_MCP2515_INSTR_READ_STATUS;
-	mcp2515_gpio_spi_write_blocking(pi_mcp2515, &instruction, 1);
-	mcp2515_gpio_spi_read_blocking(pi_mcp2515, &res, 1);
-	CS_HIGH(pi_mcp2515);
+	mcp2515_spi_transfer(pi_mcp2515, segs, 2);
 
-	MCP2515_DEBUG(pi_mcp2515, "MCP2515 status 0x%04x\n", res);
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_STATUS, res);
+
+	return (res);
+}
+
+/**
+ * @brief Check the RX buffers via the RX STATUS instruction.
+ *
+ * In one byte, this gives which RX buffers are full, as well as the type of frame and the filter it matched for the
+ * one mcp2515_can_message_read would read next (RXB0 if it is full, otherwise RXB1). See the PI_MCP2515_RX_STATUS_*
+ * definitions.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return the current RX status value.
+ */
+uint8_t
+mcp2515_rx_status(pi_mcp2515_t *pi_mcp2515)
+{
+	uint8_t instruction = PI_MCP2515_INSTR_RX_STATUS, res = 0;
+	pi_mcp2515_spi_seg_t segs[2] = {
+		{ .tx = &instruction, .len = 1 },
+		{ .rx = &res, .len = 1, .cs_change = true },
+	};
+
+	mcp2515_spi_transfer(pi_mcp2515, segs, 2);
+
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_RX_STATUS, res);
 
 	return (res);
 }
@@ -89,7 +115,8 @@ mcp2515_error_flags(pi_mcp2515_t *pi_mcp2515)
 {
 	uint8_t flags = 0;
 
-	mcp2515_register_read(pi_mcp2515, &flags, 1, PI_MCP2515_RGSTR_EFLG);
+	if (mcp2515_register_read(pi_mcp2515, &flags, 1, PI_MCP2515_RGSTR_EFLG) == 0)
+		mcp2515_stats_eflg(pi_mcp2515, flags);
 
 	return (flags);
 }
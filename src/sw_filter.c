@@ -0,0 +1,258 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The software filter is a second stage after the acceptance filters, for when the IDs wanted don't fit into six
+ * filters and two masks. Standard IDs are looked up in a bitmap with a bit for each of the 2048 of them. Extended IDs
+ * are kept in an ID table (see id_table.c).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define SW_FILTER_STD_IDS 2048
+#define SW_FILTER_EXT_MAX (1U << 20)
+
+struct mcp2515_sw_filter {
+	uint64_t std[SW_FILTER_STD_IDS / 64];
+	struct mcp2515_id_table ext;
+	uint32_t rejected;
+};
+
+static bool	sw_filter_match(const struct mcp2515_sw_filter *, uint32_t, bool);
+
+static bool
+sw_filter_match(const struct mcp2515_sw_filter *sf, uint32_t id, bool extended_id)
+{
+	if (!extended_id)
+		return (id <= PI_MCP2515_CAN_ID_SFF_MASK && (sf->std[id >> 6] >> (id & 63)) & 1);
+
+	return (mcp2515_id_table_find(&sf->ext, id, NULL));
+}
+
+/**
+ * @brief Check a received frame against the software filter, straight from the RX buffer contents.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param buffer the RX buffer contents, from SIDH onwards, of which only the ID registers are looked at.
+ * @return true if the frame is wanted, including when there is no software filter, otherwise false.
+ */
+bool
+mcp2515_sw_filter_rx(pi_mcp2515_t *pi_mcp2515, const uint8_t *buffer)
+{
+	struct mcp2515_sw_filter *sf = pi_mcp2515->sw_filter;
+	uint32_t id;
+	bool extended_id;
+
+	if (sf == NULL)
+		return (true);
+
+	id = ((uint32_t)buffer[0] << 3) | (buffer[1] >> 5);
+	if ((extended_id = !!(buffer[1] & PI_MCP2515_RXBSIDL_IDE)))
+		id = (id << 18) | ((uint32_t)(buffer[1] & 0x03) << 16) | ((uint32_t)buffer[2] << 8) | buffer[3];
+
+	if (sw_filter_match(sf, id, extended_id))
+		return (true);
+
+	/* The RX thread counts here, while the application may be reading the count. */
+#ifdef USE_PICO_LIB
+	sf->rejected++;
+#else
+	__atomic_add_fetch(&sf->rejected, 1, __ATOMIC_RELAXED);
+#endif /* USE_PICO_LIB */
+
+	return (false);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_sw_filter_functions Software Filter Functions
+ * @brief These functions handle filtering received CAN bus messages by ID in software.
+ *
+ * Once set up, the software filter is checked by the read functions and the RX thread as each frame is read, and
+ * frames whose ID hasn't been added are discarded before they reach the application. It should be changed only while
+ * nothing else is reading frames, such as before the RX thread is started.
+ * @{
+ */
+/**
+ * @brief Set up the software filter, which starts off accepting nothing.
+ *
+ * The acceptance filters still apply first, so should let through at least the IDs wanted. See also
+ * mcp2515_filter_compile, whose false positives the software filter can take out.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_sw_filter_init(pi_mcp2515_t *pi_mcp2515)
+{
+	if (pi_mcp2515->sw_filter != NULL)
+		return (-1);
+
+	if ((pi_mcp2515->sw_filter = calloc(1, sizeof(struct mcp2515_sw_filter))) == NULL)
+		return (-1);
+	mcp2515_id_table_init(&pi_mcp2515->sw_filter->ext, 0, SW_FILTER_EXT_MAX);
+
+	return (0);
+}
+
+/**
+ * @brief Free the software filter, after which every frame is accepted again.
+ *
+ * This is also done automatically by mcp2515_free.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_sw_filter_free(pi_mcp2515_t *pi_mcp2515)
+{
+	if (pi_mcp2515->sw_filter == NULL)
+		return;
+
+	mcp2515_id_table_clear(&pi_mcp2515->sw_filter->ext);
+	free(pi_mcp2515->sw_filter);
+	pi_mcp2515->sw_filter = NULL;
+}
+
+/**
+ * @brief Accept a range of IDs in the software filter.
+ *
+ * Each extended ID takes a slot in a hash table, so ranges of extended IDs should be kept short.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param range the IDs to accept.
+ * @return zero if success, otherwise non-zero, in which case some of the IDs may have been added.
+ */
+int
+mcp2515_sw_filter_add_range(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_filter_range_t *range)
+{
+	struct mcp2515_sw_filter *sf = pi_mcp2515->sw_filter;
+	uint32_t id;
+	int res = -1;
+
+	if (sf == NULL || range->first > range->last || range->last > (range->extended_id ? PI_MCP2515_CAN_ID_EFF_MASK
+	    : PI_MCP2515_CAN_ID_SFF_MASK))
+		goto err;
+	if (range->extended_id && range->last - range->first >= SW_FILTER_EXT_MAX - sf->ext.count)
+		goto err;
+
+	id = range->first;
+	do {
+		if (!range->extended_id)
+			sf->std[id >> 6] |= 1ULL << (id & 63);
+		else if (mcp2515_id_table_add(&sf->ext, id, NULL))
+			goto err;
+	} while (id++ != range->last);
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Accept an ID in the software filter.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param id the ID.
+ * @param extended_id if the ID is extended.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_sw_filter_add(pi_mcp2515_t *pi_mcp2515, uint32_t id, bool extended_id)
+{
+	pi_mcp2515_filter_range_t range = { .first = id, .last = id, .extended_id = extended_id };
+
+	return (mcp2515_sw_filter_add_range(pi_mcp2515, &range));
+}
+
+/**
+ * @brief Stop accepting an ID in the software filter.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param id the ID.
+ * @param extended_id if the ID is extended.
+ */
+void
+mcp2515_sw_filter_remove(pi_mcp2515_t *pi_mcp2515, uint32_t id, bool extended_id)
+{
+	struct mcp2515_sw_filter *sf = pi_mcp2515->sw_filter;
+
+	if (sf == NULL)
+		return;
+
+	if (extended_id)
+		mcp2515_id_table_remove(&sf->ext, id);
+	else if (id <= PI_MCP2515_CAN_ID_SFF_MASK)
+		sf->std[id >> 6] &= ~(1ULL << (id & 63));
+}
+
+/**
+ * @brief Stop accepting every ID in the software filter.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_sw_filter_clear(pi_mcp2515_t *pi_mcp2515)
+{
+	struct mcp2515_sw_filter *sf = pi_mcp2515->sw_filter;
+
+	if (sf == NULL)
+		return;
+
+	memset(sf->std, 0, sizeof(sf->std));
+	mcp2515_id_table_clear(&sf->ext);
+}
+
+/**
+ * @brief Check if the software filter accepts an ID.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param id the ID.
+ * @param extended_id if the ID is extended.
+ * @return true if the ID is accepted, including when there is no software filter, otherwise false.
+ */
+bool
+mcp2515_sw_filter_accepts(const pi_mcp2515_t *pi_mcp2515, uint32_t id, bool extended_id)
+{
+	if (pi_mcp2515->sw_filter == NULL)
+		return (true);
+
+	return (sw_filter_match(pi_mcp2515->sw_filter, id, extended_id));
+}
+
+/**
+ * @brief Get how many received frames the software filter has discarded.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return the number of frames discarded, or zero if there is no software filter.
+ */
+uint32_t
+mcp2515_sw_filter_rejected(const pi_mcp2515_t *pi_mcp2515)
+{
+	if (pi_mcp2515->sw_filter == NULL)
+		return (0);
+
+#ifdef USE_PICO_LIB
+	return (pi_mcp2515->sw_filter->rejected);
+#else
+	return (__atomic_load_n(&pi_mcp2515->sw_filter->rejected, __ATOMIC_RELAXED));
+#endif /* USE_PICO_LIB */
+}
+/** @} */
@@ -16,6 +16,7 @@
 #ifdef USE_PICO_LIB
 #include "pico/time.h"
 #else
+#include <time.h>
 #include <unistd.h>
 #endif
 
@@ -33,6 +34,46 @@ mcp2515_micro_sleep(uint64_t micro_s)
 #endif
 }
 
+/*! @cond DOXYGEN_IGNORE */
+/**
+ * @brief Get a monotonic timestamp, for measuring intervals.
+ *
+ * @return the time in microseconds since an arbitrary point.
+ */
+uint64_t
+mcp2515_time_usec(void)
+{
+#ifdef USE_PICO_LIB
+	return (time_us_64());
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL);
+#endif
+}
+
+/**
+ * @brief Get a monotonic timestamp in nanoseconds, on the same clock as the kernel's GPIO edge event timestamps.
+ *
+ * @return the time in nanoseconds since an arbitrary point.
+ */
+uint64_t
+mcp2515_time_nsec(void)
+{
+#ifdef USE_PICO_LIB
+	return (time_us_64() * 1000ULL);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+}
+/*! @endcond */
+
 /**
  * @brief Calculate the time for the number of oscillator cycles supplied, and based on the oscillator frequency.
  *
@@ -49,3 +90,28 @@ mcp2515_osc_time(const pi_mcp2515_t *pi_mcp2515, uint32_t num_cycles)
 
 	return (num_cycles * cycle_len_nano_sec / 1000L); /* return microseconds */
 }
+
+/**
+ * @brief Convert a received frame's timestamp (see pi_mcp2515_can_rx_frame_t) to wall clock time.
+ *
+ * The offset between the clocks is taken now, so a timestamp converted long after it was taken moves with any change
+ * made to the wall clock since. On the Pico, which has no wall clock, the timestamp is returned as it is.
+ *
+ * @param timestamp the timestamp, in nanoseconds of CLOCK_MONOTONIC.
+ * @return the timestamp in nanoseconds of CLOCK_REALTIME, since the Unix epoch.
+ */
+uint64_t
+mcp2515_timestamp_realtime(uint64_t timestamp)
+{
+#ifdef USE_PICO_LIB
+	return (timestamp);
+#else
+	struct timespec real, mono;
+
+	clock_gettime(CLOCK_REALTIME, &real);
+	clock_gettime(CLOCK_MONOTONIC, &mono);
+
+	return (timestamp + ((uint64_t)real.tv_sec * 1000000000ULL + (uint64_t)real.tv_nsec)
+	    - ((uint64_t)mono.tv_sec * 1000000000ULL + (uint64_t)mono.tv_nsec));
+#endif
+}
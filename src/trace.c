@@ -0,0 +1,228 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The trace is a ring of fixed size binary events, which any thread may record into without a lock. Each claims a slot
+ * by bumping the head, then stamps the slot's sequence number once it has finished writing it. A snapshot copies out
+ * the slots whose sequence number is the one expected both before and after copying, so skips anything overwritten or
+ * still being written. Formatting the events is left to whoever reads them, such as tools/tracedump.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef USE_SPI
+#include <unistd.h>
+#endif /* USE_SPI */
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define TRACE_EVENTS_MAX (1U << 20)
+
+struct mcp2515_trace {
+	pi_mcp2515_trace_event_t *events; /* Each slot's seq is one more than its position once written. */
+	uint32_t mask;
+	uint32_t head; /* The position of the next event to record. */
+};
+
+void
+mcp2515_trace_record(const pi_mcp2515_t *pi_mcp2515, uint16_t event, const uint32_t *args)
+{
+	struct mcp2515_trace *tr = pi_mcp2515->trace;
+	pi_mcp2515_trace_event_t *ev;
+	uint32_t pos;
+
+#ifdef USE_PICO_LIB
+	pos = tr->head++;
+	ev = &tr->events[pos & tr->mask];
+	ev->seq = pos;
+#else
+	pos = __atomic_fetch_add(&tr->head, 1, __ATOMIC_RELAXED);
+	ev = &tr->events[pos & tr->mask];
+	/* Not the sequence number a reader expects for this position, or for the one it is overwriting. */
+	__atomic_store_n(&ev->seq, pos, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+#endif /* USE_PICO_LIB */
+
+	ev->timestamp = mcp2515_time_nsec();
+	ev->event = event;
+	memcpy(ev->args, args, sizeof(ev->args));
+
+#ifdef USE_PICO_LIB
+	ev->seq = pos + 1;
+#else
+	__atomic_store_n(&ev->seq, pos + 1, __ATOMIC_RELEASE);
+#endif /* USE_PICO_LIB */
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_trace_functions Trace Functions
+ * @brief These functions handle recording what the library does into a ring of binary trace events.
+ *
+ * Recording an event costs a timestamp and a few stores, with no formatting and no locking, so unlike debug logging
+ * (see mcp2515_debug_enable) tracing can be left on in production. Once the ring is full, the oldest events are
+ * overwritten. Compile with NO_TRACE defined to leave out tracing altogether.
+ * @{
+ */
+/**
+ * @brief Set up tracing, which records events from then on.
+ *
+ * This should be done before starting the RX thread, if it is used.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param events how many events the ring holds, which is rounded up to a power of two.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_trace_init(pi_mcp2515_t *pi_mcp2515, uint32_t events)
+{
+	struct mcp2515_trace *tr;
+	uint32_t size = 1;
+	int res = -1;
+
+	if (pi_mcp2515->trace != NULL || events == 0 || events > TRACE_EVENTS_MAX)
+		goto end;
+	while (size < events)
+		size <<= 1;
+
+	if ((tr = calloc(1, sizeof(*tr))) == NULL)
+		goto end;
+	if ((tr->events = calloc(size, sizeof(pi_mcp2515_trace_event_t))) == NULL) {
+		free(tr);
+		goto end;
+	}
+	tr->mask = size - 1;
+
+	pi_mcp2515->trace = tr;
+	res = 0;
+
+end:
+	return (res);
+}
+
+/**
+ * @brief Stop tracing, and free the trace.
+ *
+ * This should only be done while nothing else is using the handle, such as after stopping the RX thread.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_trace_free(pi_mcp2515_t *pi_mcp2515)
+{
+	struct mcp2515_trace *tr = pi_mcp2515->trace;
+
+	if (tr == NULL)
+		return;
+
+	pi_mcp2515->trace = NULL;
+	free(tr->events);
+	free(tr);
+}
+
+/**
+ * @brief Copy out the most recent trace events, oldest first.
+ *
+ * This can be called while events are being recorded. Any event overwritten or still being written as it is copied is
+ * left out, which shows up as a gap in the events' sequence numbers.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param events where to put the events.
+ * @param max the length of the @p events array.
+ * @return how many events were copied, which is zero if tracing isn't set up.
+ */
+size_t
+mcp2515_trace_snapshot(const pi_mcp2515_t *pi_mcp2515, pi_mcp2515_trace_event_t *events, size_t max)
+{
+	const struct mcp2515_trace *tr = pi_mcp2515->trace;
+	const pi_mcp2515_trace_event_t *ev;
+	uint32_t head, pos, seq;
+	size_t n = 0;
+
+	if (tr == NULL || max == 0)
+		goto end;
+
+#ifdef USE_PICO_LIB
+	head = tr->head;
+#else
+	head = __atomic_load_n(&tr->head, __ATOMIC_ACQUIRE);
+#endif /* USE_PICO_LIB */
+	pos = head > tr->mask ? head - tr->mask - 1 : 0;
+	if (head - pos > max)
+		pos = head - (uint32_t)max;
+
+	for (; pos != head; pos++) {
+		ev = &tr->events[pos & tr->mask];
+#ifdef USE_PICO_LIB
+		if ((seq = ev->seq) != pos + 1)
+			continue;
+		events[n] = *ev;
+#else
+		if ((seq = __atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE)) != pos + 1)
+			continue;
+		memcpy(&events[n], ev, sizeof(*ev));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&ev->seq, __ATOMIC_RELAXED) != seq)
+			continue;
+#endif /* USE_PICO_LIB */
+		events[n++].seq = pos;
+	}
+
+end:
+	return (n);
+}
+
+#ifdef USE_SPI
+/**
+ * @brief Write the trace to a file, in the format tools/tracedump reads.
+ *
+ * A pi_mcp2515_trace_header_t is written, followed by the events in a snapshot (see mcp2515_trace_snapshot) of the
+ * whole ring. This is not available on the Pico.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param fd the file descriptor to write to.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_trace_save(const pi_mcp2515_t *pi_mcp2515, int fd)
+{
+	pi_mcp2515_trace_header_t header = { 0 };
+	pi_mcp2515_trace_event_t *events;
+	ssize_t len;
+	int res = -1;
+
+	if (pi_mcp2515->trace == NULL)
+		goto end;
+	if ((events = calloc(pi_mcp2515->trace->mask + 1, sizeof(*events))) == NULL)
+		goto end;
+
+	header.magic = PI_MCP2515_TRACE_MAGIC;
+	header.version = PI_MCP2515_TRACE_VERSION;
+	header.event_size = sizeof(pi_mcp2515_trace_event_t);
+	header.count = mcp2515_trace_snapshot(pi_mcp2515, events, pi_mcp2515->trace->mask + 1);
+	len = (ssize_t)(header.count * sizeof(*events));
+
+	if (write(fd, &header, sizeof(header)) == sizeof(header) && write(fd, events, len) == len)
+		res = 0;
+
+	free(events);
+end:
+	return (res);
+}
+#endif /* USE_SPI */
+/** @} */
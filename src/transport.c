@@ -0,0 +1,173 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+static void	gpio_transport_free(pi_mcp2515_t *);
+
+const pi_mcp2515_transport_t mcp2515_transport_gpio = {
+	.transfer = mcp2515_gpio_spi_transfer,
+	.free = gpio_transport_free,
+};
+
+static void
+gpio_transport_free(pi_mcp2515_t *pi_mcp2515)
+{
+	mcp2515_gpio_spi_free(pi_mcp2515);
+}
+
+/**
+ * @brief Allocate a zeroed pi_mcp2515_t structure.
+ *
+ * @param pi_mcp2515 where to put the new handle.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_handle_alloc(pi_mcp2515_t **pi_mcp2515)
+{
+	int res = 0;
+
+	if ((*pi_mcp2515 = calloc(1, sizeof(pi_mcp2515_t))) == NULL) {
+		res = -1;
+		goto err;
+	}
+
+#ifdef USE_SPI
+	if (pthread_mutex_init(&(*pi_mcp2515)->lock, NULL)) {
+		free(*pi_mcp2515);
+		*pi_mcp2515 = NULL;
+		res = -1;
+	}
+#endif
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Release everything held by a pi_mcp2515_t structure, and the structure itself.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_handle_free(pi_mcp2515_t *pi_mcp2515)
+{
+#ifdef USE_SPI
+	mcp2515_rx_thread_stop(pi_mcp2515);
+#endif
+	mcp2515_tx_queue_free(pi_mcp2515);
+	mcp2515_sw_filter_free(pi_mcp2515);
+	mcp2515_dispatch_free(pi_mcp2515);
+	if (pi_mcp2515->transport != NULL && pi_mcp2515->transport->free != NULL)
+		pi_mcp2515->transport->free(pi_mcp2515);
+	mcp2515_trace_free(pi_mcp2515);
+#ifdef USE_SPI
+	pthread_mutex_destroy(&pi_mcp2515->lock);
+#endif
+	free(pi_mcp2515);
+}
+
+/**
+ * @brief Perform an SPI transaction via the handle's transport.
+ *
+ * Everything the library sends to or reads from the MCP2515 goes through here.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param segs the segments of the transaction.
+ * @param n the number of segments.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_spi_transfer(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_spi_seg_t *segs, uint8_t n)
+{
+	uint32_t bytes = 0;
+	uint8_t i;
+	int res;
+
+	for (i = 0; i < n; i++)
+		bytes += segs[i].len;
+	MCP2515_STAT_ADD(pi_mcp2515, spi_transactions, 1);
+	MCP2515_STAT_ADD(pi_mcp2515, spi_bytes, bytes);
+
+#ifdef USE_SPI
+	/* The RX thread may be transferring at the same time as the application. */
+	pthread_mutex_lock(&pi_mcp2515->lock);
+#endif
+	res = pi_mcp2515->transport->transfer(pi_mcp2515, segs, n);
+#ifdef USE_SPI
+	pthread_mutex_unlock(&pi_mcp2515->lock);
+#endif
+	MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_SPI, n, bytes, (uint32_t)res);
+
+	return (res);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_transport_functions Transport Functions
+ * @brief These functions handle setting up a handle with an alternate transport.
+ * @{
+ */
+/**
+ * @brief Set up a pi_mcp2515_t structure which communicates through the transport provided rather than SPI.
+ *
+ * This allows swapping the hardware out for something else entirely, such as the simulated MCP2515 used by
+ * mcp2515_init_sim, or an instrumented transport for benchmarking. Nothing is done with the GPIO or SPI hardware.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param transport the transport operations to use. This must remain valid until the handle is freed.
+ * @param ctx an arbitrary pointer for the transport's own use (see mcp2515_transport_ctx).
+ * @param osc_mhz the frequency of the MCP2515 oscillator in MHz.
+ * @return zero if success, otherwise non-zero
+ */
+int
+mcp2515_init_transport(pi_mcp2515_t **pi_mcp2515, const pi_mcp2515_transport_t *transport, void *ctx, uint8_t osc_mhz)
+{
+	int res = 0;
+
+	if (transport == NULL || transport->transfer == NULL || osc_mhz > 40 || osc_mhz == 0) {
+		res = 1;
+		goto err;
+	}
+
+	if ((res = mcp2515_handle_alloc(pi_mcp2515)))
+		goto err;
+
+	(*pi_mcp2515)->transport = transport;
+	(*pi_mcp2515)->transport_ctx = ctx;
+	(*pi_mcp2515)->osc_mhz = osc_mhz;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Get the transport context pointer given to mcp2515_init_transport.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return the transport context pointer.
+ */
+void *
+mcp2515_transport_ctx(const pi_mcp2515_t *pi_mcp2515)
+{
+	return (pi_mcp2515->transport_ctx);
+}
+/** @} */
@@ -0,0 +1,443 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The TX queue keeps all three TX buffers loaded from a software queue, so the bus can be kept busy without the caller
+ * having to juggle TX buffers and retry when they are all in use.
+ *
+ * Queued frames are kept in a binary heap, ordered by when they were queued or, in priority order, by how they would
+ * win arbitration on the bus. The MCP2515 sends whichever pending TX buffer has the highest priority (TXP), with the
+ * highest buffer number winning a tie, so each frame loaded is given a (TXP, buffer) pair, or rank, that fits between
+ * the ranks of the frames already loaded. In priority order, a frame that can't be placed aborts the loaded frames it
+ * should go ahead of, which are queued again. In FIFO order, the frames still loaded are raised back up the ranks when
+ * there is no room left below them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+#define TX_QUEUE_MAX (1U << 16)
+#define TX_QUEUE_RANK(txp, txb) ((txp) * 3 + (txb))
+#define TX_QUEUE_RANKS 12
+
+struct tx_queue_entry {
+	uint32_t arb; /* Lower goes first, and is always zero in FIFO order. */
+	uint64_t seq;
+	pi_mcp2515_can_frame_t frame;
+};
+
+struct mcp2515_tx_queue {
+	mcp2515_tx_queue_order_t order;
+	struct tx_queue_entry *heap;
+	uint32_t len;
+	uint32_t count;
+	uint64_t seq;
+	struct tx_queue_entry loaded[3];
+	uint8_t rank[3];
+	uint8_t aborting; /* TX buffers the TX queue has aborted, whose outcome hasn't been collected. */
+	pi_mcp2515_tx_queue_stats_t stats;
+};
+
+static uint32_t	tx_queue_arb(const pi_mcp2515_can_frame_t *);
+static bool	tx_queue_before(const struct tx_queue_entry *, const struct tx_queue_entry *);
+static void	tx_queue_heap_push(struct mcp2515_tx_queue *, const struct tx_queue_entry *);
+static void	tx_queue_heap_pop(struct mcp2515_tx_queue *);
+static uint8_t	tx_queue_raise(pi_mcp2515_t *, struct mcp2515_tx_queue *, uint8_t (*)[4], pi_mcp2515_spi_seg_t *);
+
+/**
+ * @brief Get a key ordering a frame as it would be by arbitration on the bus, where lower wins.
+ *
+ * The key follows the arbitration field bit for bit: the base ID, then the RTR bit of a standard frame or the SRR bit
+ * of an extended frame, then IDE, then the extended ID and the RTR bit of an extended frame.
+ *
+ * @param frame the CAN bus frame.
+ * @return the key.
+ */
+static uint32_t
+tx_queue_arb(const pi_mcp2515_can_frame_t *frame)
+{
+	uint32_t res;
+
+	if (frame->extended_id)
+		res = ((frame->id >> 18) & 0x7FF) << 21 | 1 << 20 | 1 << 19 | (frame->id & 0x3FFFF) << 1 | frame->rtr;
+	else
+		res = (frame->id & 0x7FF) << 21 | (uint32_t)frame->rtr << 20;
+
+	return (res);
+}
+
+static bool
+tx_queue_before(const struct tx_queue_entry *a, const struct tx_queue_entry *b)
+{
+	return (a->arb != b->arb ? a->arb < b->arb : a->seq < b->seq);
+}
+
+static void
+tx_queue_heap_push(struct mcp2515_tx_queue *tq, const struct tx_queue_entry *entry)
+{
+	uint32_t i, parent;
+
+	for (i = tq->count++; i > 0; i = parent) {
+		parent = (i - 1) / 2;
+		if (!tx_queue_before(entry, &tq->heap[parent]))
+			break;
+		tq->heap[i] = tq->heap[parent];
+	}
+	tq->heap[i] = *entry;
+}
+
+static void
+tx_queue_heap_pop(struct mcp2515_tx_queue *tq)
+{
+	struct tx_queue_entry *last = &tq->heap[--tq->count];
+	uint32_t i = 0, child;
+
+	while ((child = 2 * i + 1) < tq->count) {
+		if (child + 1 < tq->count && tx_queue_before(&tq->heap[child + 1], &tq->heap[child]))
+			child++;
+		if (!tx_queue_before(&tq->heap[child], last))
+			break;
+		tq->heap[i] = tq->heap[child];
+		i = child;
+	}
+	tq->heap[i] = *last;
+}
+
+/**
+ * @brief Raise the ranks of the loaded messages as high as they go, keeping them in order, to make room below them.
+ *
+ * In FIFO order, each message loaded has to go below every loaded rank, so the ranks run out after a dozen messages
+ * unless the messages still waiting to send are moved back up. Only TXP changes, and each message is raised before the
+ * one behind it, so the order they send in holds throughout, whenever the MCP2515 picks the next one.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param tq the TX queue.
+ * @param cmds space for a BIT MODIFY of each TX buffer's TXP.
+ * @param segs where to put the segments for the BIT MODIFY commands.
+ * @return the number of segments added.
+ */
+static uint8_t
+tx_queue_raise(pi_mcp2515_t *pi_mcp2515, struct mcp2515_tx_queue *tq, uint8_t (*cmds)[4], pi_mcp2515_spi_seg_t *segs)
+{
+	uint8_t order[3], n = 0, seg_n = 0, i, j;
+	int rank, ceiling = TX_QUEUE_RANKS, txp;
+
+	/* Highest rank, which is sent first, first. */
+	for (i = 0; i < 3; i++) {
+		if (!(pi_mcp2515->tx_queued & (1 << i)))
+			continue;
+		for (j = n++; j > 0 && tq->rank[order[j - 1]] < tq->rank[i]; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+
+	for (j = 0; j < n; j++) {
+		i = order[j];
+		for (txp = 3; TX_QUEUE_RANK(txp, i) >= ceiling; txp--)
+			;
+		ceiling = rank = TX_QUEUE_RANK(txp, i);
+		if (rank == tq->rank[i])
+			continue;
+		tq->rank[i] = rank;
+		cmds[seg_n][0] = PI_MCP2515_INSTR_BITMOD;
+		cmds[seg_n][1] = PI_MCP2515_RGSTR_TXB0CTRL + (i << 4);
+		cmds[seg_n][2] = PI_MCP2515_CTRL_TXP_MASK;
+		cmds[seg_n][3] = txp;
+		memset(&segs[seg_n], 0, sizeof(segs[seg_n]));
+		segs[seg_n].tx = cmds[seg_n];
+		segs[seg_n].len = sizeof(cmds[0]);
+		segs[seg_n++].cs_change = true;
+	}
+
+	return (seg_n);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_tx_queue_functions TX Queue Functions
+ * @brief These functions handle sending CAN bus messages through a software queue.
+ *
+ * While the TX queue is in use, TX buffers are shared between it and the other send functions, but the TX queue will
+ * always use any which are free. These functions must not be called from several threads at once.
+ * @{
+ */
+/**
+ * @brief Set up the TX queue.
+ *
+ * In FIFO order, messages are sent in the order they are queued. In priority order, the most urgent message, as
+ * decided by arbitration on the bus, is always sent first. If a message can't be loaded ahead of less urgent messages
+ * already in TX buffers, those are aborted and queued again, so a loaded message never holds up a more urgent one.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param size how many messages the TX queue holds.
+ * @param order the order to send messages in.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_tx_queue_init(pi_mcp2515_t *pi_mcp2515, uint32_t size, mcp2515_tx_queue_order_t order)
+{
+	struct mcp2515_tx_queue *tq;
+	int res = -1;
+
+	if (pi_mcp2515->tx_queue != NULL || size == 0 || size > TX_QUEUE_MAX)
+		goto err;
+
+	if ((tq = calloc(1, sizeof(*tq))) == NULL)
+		goto err;
+	/* Room for aborted messages to go back in, even when the TX queue is full. */
+	if ((tq->heap = calloc(size + 3, sizeof(struct tx_queue_entry))) == NULL) {
+		free(tq);
+		goto err;
+	}
+	tq->len = size;
+	tq->order = order;
+
+	pi_mcp2515->tx_queue = tq;
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Free the TX queue, discarding any messages not yet loaded into a TX buffer.
+ *
+ * Messages already in TX buffers are left to send. This is also done automatically by mcp2515_free.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ */
+void
+mcp2515_tx_queue_free(pi_mcp2515_t *pi_mcp2515)
+{
+	if (pi_mcp2515->tx_queue == NULL)
+		return;
+
+	free(pi_mcp2515->tx_queue->heap);
+	free(pi_mcp2515->tx_queue);
+	pi_mcp2515->tx_queue = NULL;
+	pi_mcp2515->tx_queued = 0;
+}
+
+/**
+ * @brief Add a CAN bus message to the TX queue.
+ *
+ * This doesn't involve any SPI traffic. The message is sent once mcp2515_tx_queue_service loads it into a TX buffer.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param can_frame the CAN bus frame to send.
+ * @return zero if success, otherwise non-zero if the TX queue is full or not set up.
+ */
+int
+mcp2515_tx_queue_push(pi_mcp2515_t *pi_mcp2515, const pi_mcp2515_can_frame_t *can_frame)
+{
+	struct mcp2515_tx_queue *tq = pi_mcp2515->tx_queue;
+	struct tx_queue_entry entry;
+	int res = -1;
+
+	if (tq == NULL || tq->count >= tq->len)
+		goto err;
+
+	entry.arb = tq->order == PI_MCP2515_TX_QUEUE_PRIORITY ? tx_queue_arb(can_frame) : 0;
+	entry.seq = tq->seq++;
+	memcpy(&entry.frame, can_frame, sizeof(*can_frame));
+	tx_queue_heap_push(tq, &entry);
+	res = 0;
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Collect sent messages from the TX buffers, and load the free TX buffers from the TX queue.
+ *
+ * Call this after queueing messages, and again whenever a TX buffer empties, to keep the TX buffers full. With the
+ * TXnIE interrupts enabled (see mcp2515_interrupts_enable), that is whenever mcp2515_int_wait reports an interrupt.
+ * While the RX thread is running with an INT pin, mcp2515_int_wait can't be used, so call this on a timer instead,
+ * at least as often as a frame takes to send.
+ * This takes one READ STATUS, plus one SPI transaction for everything else, and both again if messages had to be
+ * aborted to make way for a more urgent one.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @return zero if success, otherwise non-zero.
+ */
+int
+mcp2515_tx_queue_service(pi_mcp2515_t *pi_mcp2515)
+{
+	struct mcp2515_tx_queue *tq = pi_mcp2515->tx_queue;
+	struct mcp2515_tx_load loads[3];
+	pi_mcp2515_spi_seg_t segs[1 + 3 * MCP2515_TX_LOAD_SEGS + 3];
+	uint8_t aborts[3][4]; /* Or in FIFO order, TXP changes (see tx_queue_raise). */
+	const struct tx_queue_entry *next;
+	int res = -1, lo, hi, rank, best, txp, pass;
+	uint8_t status, clear[4], free_txbs, seg_n, load_n, abort_n, best_txb = 0, i;
+	bool raised;
+
+	if (tq == NULL)
+		goto err;
+
+	for (pass = 0; pass < 2; pass++) {
+		status = mcp2515_status(pi_mcp2515);
+		clear[0] = PI_MCP2515_INSTR_BITMOD;
+		clear[1] = PI_MCP2515_RGSTR_CANINTF;
+		clear[2] = 0;
+		clear[3] = 0;
+		seg_n = 1;
+		load_n = 0;
+		abort_n = 0;
+		raised = false;
+
+		/* Collect whatever has finished. TXnIF is only set when the message was actually sent. */
+		for (i = 0; i < 3; i++) {
+			if (!(pi_mcp2515->tx_queued & (1 << i)) || (status & (PI_MCP2515_STATUS_TX0REQ << (i * 2))))
+				continue;
+			if (status & (PI_MCP2515_STATUS_TX0IF << (i * 2))) {
+				tq->stats.sent++;
+				MCP2515_STAT_ADD(pi_mcp2515, frames_tx, 1);
+				clear[2] |= PI_MCP2515_CANINTF_TX0IF << i;
+			} else if (tq->aborting & (1 << i)) {
+				tq->stats.preempted++;
+				tx_queue_heap_push(tq, &tq->loaded[i]);
+			} else {
+				tq->stats.failed++;
+				MCP2515_STAT_ADD(pi_mcp2515, tx_errors, 1);
+			}
+			pi_mcp2515->tx_queued &= ~(1 << i);
+			tq->aborting &= ~(1 << i);
+		}
+
+		free_txbs = mcp2515_can_tx_free(pi_mcp2515, status);
+		while (tq->count > 0) {
+			next = &tq->heap[0];
+
+			/* Find the ranks of the loaded messages either side of this one. */
+			lo = -1;
+			hi = TX_QUEUE_RANKS;
+			for (i = 0; i < 3; i++) {
+				if (!(pi_mcp2515->tx_queued & (1 << i)))
+					continue;
+				if (tx_queue_before(&tq->loaded[i], next)) {
+					if (tq->rank[i] < hi)
+						hi = tq->rank[i];
+				} else if (tq->rank[i] > lo)
+					lo = tq->rank[i];
+			}
+
+			/*
+			 * In FIFO order, nothing comes after the message just loaded, so take the highest rank. Otherwise,
+			 * take the middle rank to leave room for more urgent and less urgent messages alike.
+			 */
+			best = -1;
+			for (i = 0; i < 3; i++) {
+				if (!(free_txbs & (1 << i)))
+					continue;
+				for (txp = 0; txp < 4; txp++) {
+					rank = TX_QUEUE_RANK(txp, i);
+					if (rank <= lo || rank >= hi)
+						continue;
+					if (best < 0 || (tq->order == PI_MCP2515_TX_QUEUE_FIFO ? rank > best
+					    : abs(2 * rank - (lo + hi)) < abs(2 * best - (lo + hi)))) {
+						best = rank;
+						best_txb = i;
+					}
+				}
+			}
+
+			if (best < 0 && tq->order == PI_MCP2515_TX_QUEUE_FIFO) {
+				if (raised || free_txbs == 0)
+					break;
+				seg_n += tx_queue_raise(pi_mcp2515, tq, aborts, &segs[seg_n]);
+				raised = true;
+				continue;
+			}
+			if (best < 0) {
+				/* Abort everything this message should go ahead of, to be loaded again after it. */
+				for (i = 0; i < 3; i++) {
+					if (!(pi_mcp2515->tx_queued & (1 << i)) || (tq->aborting & (1 << i))
+					    || tx_queue_before(&tq->loaded[i], next))
+						continue;
+					aborts[abort_n][0] = PI_MCP2515_INSTR_BITMOD;
+					aborts[abort_n][1] = PI_MCP2515_RGSTR_TXB0CTRL + (i << 4);
+					aborts[abort_n][2] = PI_MCP2515_CTRL_TXREQ;
+					aborts[abort_n][3] = 0;
+					memset(&segs[seg_n], 0, sizeof(segs[seg_n]));
+					segs[seg_n].tx = aborts[abort_n++];
+					segs[seg_n].len = sizeof(aborts[0]);
+					segs[seg_n++].cs_change = true;
+					tq->aborting |= 1 << i;
+				}
+				break;
+			}
+
+			seg_n += mcp2515_can_tx_load_prepare(&loads[load_n++], &segs[seg_n], best_txb, best / 3,
+			    &next->frame);
+			MCP2515_TRACE(pi_mcp2515, PI_MCP2515_TRACE_TX_LOAD, best_txb,
+			    MCP2515_TRACE_HDR(loads[load_n - 1].payload), loads[load_n - 1].payload[4]);
+			tq->loaded[best_txb] = *next;
+			tq->rank[best_txb] = best;
+			tx_queue_heap_pop(tq);
+			clear[2] &= ~(PI_MCP2515_CANINTF_TX0IF << best_txb);
+			free_txbs &= ~(1 << best_txb);
+			pi_mcp2515->tx_queued |= 1 << best_txb;
+		}
+
+		/* Loading a TX buffer clears its TXnIF anyway, but others sent and not reloaded need it cleared first. */
+		if (clear[2]) {
+			memset(&segs[0], 0, sizeof(segs[0]));
+			segs[0].tx = clear;
+			segs[0].len = sizeof(clear);
+			segs[0].cs_change = true;
+			res = mcp2515_spi_transfer(pi_mcp2515, segs, seg_n);
+		} else
+			res = seg_n > 1 ? mcp2515_spi_transfer(pi_mcp2515, &segs[1], seg_n - 1) : 0;
+
+		/* An aborted message not already on the bus is out of its TX buffer straight away. */
+		if (res != 0 || abort_n == 0)
+			break;
+	}
+
+err:
+	return (res);
+}
+
+/**
+ * @brief Get the TX queue's counters.
+ *
+ * The counters are zeroed if the TX queue isn't set up.
+ *
+ * @param pi_mcp2515 the piMCP2515 handle.
+ * @param stats where to put the counters.
+ */
+void
+mcp2515_tx_queue_stats(const pi_mcp2515_t *pi_mcp2515, pi_mcp2515_tx_queue_stats_t *stats)
+{
+	const struct mcp2515_tx_queue *tq = pi_mcp2515->tx_queue;
+	uint8_t i;
+
+	memset(stats, 0, sizeof(*stats));
+	if (tq == NULL)
+		return;
+
+	memcpy(stats, &tq->stats, sizeof(*stats));
+	stats->queued = tq->count;
+	for (i = 0; i < 3; i++)
+		if (pi_mcp2515->tx_queued & (1 << i))
+			stats->loaded++;
+}
+/** @} */
@@ -0,0 +1,179 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include <pi_MCP2515.h>
+
+#include "internal.h"
+
+/*! @cond DOXYGEN_IGNORE */
+
+/*
+ * These are branch-free and inline, so the batch conversions are plain loops over independent frames, which the
+ * compiler is free to unroll or vectorize.
+ */
+static inline void
+wire_encode(const pi_mcp2515_can_frame_t *can_frame, uint8_t *regs)
+{
+	uint32_t ext = -(uint32_t)can_frame->extended_id, id, sid;
+
+	id = can_frame->id & (PI_MCP2515_CAN_ID_SFF_MASK | (ext & PI_MCP2515_CAN_ID_EFF_MASK));
+	sid = id >> (ext & 18);
+	regs[0] = (uint8_t)(sid >> 3);
+	regs[1] = (uint8_t)(((sid & 0x07) << 5) | (ext & (PI_MCP2515_TXBSIDL_EXIDE | ((id >> 16) & 0x03))));
+	regs[2] = (uint8_t)(ext & (id >> 8));
+	regs[3] = (uint8_t)(ext & id);
+	regs[4] = (uint8_t)((can_frame->dlc & PI_MCP2515_CAN_DLC_RTR_MASK)
+	    | (-(uint32_t)can_frame->rtr & PI_MCP2515_CAN_DLC_RTR_FLAG));
+	memcpy(&regs[5], can_frame->payload, PI_MCP2515_CAN_FRAME_PAYLOAD_MAX);
+}
+
+static inline void
+wire_decode(const uint8_t *regs, pi_mcp2515_can_frame_t *can_frame)
+{
+	uint32_t ext = -(uint32_t)!!(regs[1] & PI_MCP2515_TXBSIDL_EXIDE), id;
+	uint8_t dlc = regs[4] & PI_MCP2515_CAN_DLC_RTR_MASK;
+
+	id = ((uint32_t)regs[0] << 3) | (regs[1] >> 5);
+	can_frame->id = (id & ~ext) | (ext & ((id << 18) | ((uint32_t)(regs[1] & 0x03) << 16)
+	    | ((uint32_t)regs[2] << 8) | regs[3]));
+	can_frame->extended_id = ext != 0;
+	can_frame->rtr = !!(regs[4] & PI_MCP2515_CAN_DLC_RTR_FLAG);
+	/* A DLC above 8 is valid on the bus, but still means 8 bytes of payload. */
+	can_frame->dlc = dlc > PI_MCP2515_CAN_FRAME_PAYLOAD_MAX ? PI_MCP2515_CAN_FRAME_PAYLOAD_MAX : dlc;
+	memcpy(can_frame->payload, &regs[5], PI_MCP2515_CAN_FRAME_PAYLOAD_MAX);
+}
+
+/**
+ * @brief Get how many bytes of a frame laid out as in the TX buffer registers need loading.
+ *
+ * @param regs the frame, from SIDH through to D7.
+ * @return the number of bytes, which leaves off the payload of remote frames.
+ */
+uint8_t
+mcp2515_wire_frame_len(const uint8_t *regs)
+{
+	uint8_t dlc = regs[4] & PI_MCP2515_CAN_DLC_RTR_MASK;
+
+	if (regs[4] & PI_MCP2515_CAN_DLC_RTR_FLAG)
+		return (5);
+
+	/* A DLC above 8 is valid on the bus, but there are still only 8 bytes of payload. */
+	return (5 + (dlc > PI_MCP2515_CAN_FRAME_PAYLOAD_MAX ? PI_MCP2515_CAN_FRAME_PAYLOAD_MAX : dlc));
+}
+
+/**
+ * @brief Lay out a CAN bus frame as it is loaded into a TX buffer.
+ *
+ * @param can_frame the CAN bus frame.
+ * @param buffer where to put the frame, which must have room for MCP2515_FRAME_LEN bytes.
+ * @return the number of bytes to load, which leaves off the payload of remote frames.
+ */
+uint8_t
+mcp2515_can_frame_encode(const pi_mcp2515_can_frame_t *can_frame, uint8_t *buffer)
+{
+	wire_encode(can_frame, buffer);
+
+	return (mcp2515_wire_frame_len(buffer));
+}
+
+/**
+ * @brief Rearrange a frame read from an RX buffer into the TX buffer layout.
+ *
+ * The RX buffers flag standard remote frames with SRR in SIDL, and only flag extended ones in the DLC register.
+ *
+ * @param regs the frame, from SIDH through to D7, which is rearranged in place.
+ */
+void
+mcp2515_wire_frame_from_rx(uint8_t *regs)
+{
+	bool rtr;
+
+	if (regs[1] & PI_MCP2515_RXBSIDL_IDE)
+		rtr = !!(regs[4] & PI_MCP2515_CAN_DLC_RTR_FLAG);
+	else
+		rtr = !!(regs[1] & PI_MCP2515_RXBSIDL_SRR);
+
+	regs[1] &= 0xE0 | PI_MCP2515_TXBSIDL_EXIDE | 0x03;
+	regs[4] = (regs[4] & PI_MCP2515_CAN_DLC_RTR_MASK) | (rtr ? PI_MCP2515_CAN_DLC_RTR_FLAG : 0);
+}
+/*! @endcond */
+
+/**
+ * @defgroup piMCP2515_wire_functions Wire Frame Functions
+ * @brief These functions convert CAN bus frames to and from the layout of the MCP2515's TX buffer registers.
+ *
+ * Unlike mcp2515_can_message_read, decoding always copies the whole payload, including for remote frames.
+ * @{
+ */
+/**
+ * @brief Encode a CAN bus frame as a wire frame.
+ *
+ * @param can_frame the CAN bus frame.
+ * @param wire_frame where to put the wire frame.
+ */
+void
+mcp2515_wire_frame_encode(const pi_mcp2515_can_frame_t *can_frame, pi_mcp2515_wire_frame_t *wire_frame)
+{
+	wire_encode(can_frame, wire_frame->regs);
+}
+
+/**
+ * @brief Decode a wire frame.
+ *
+ * @param wire_frame the wire frame.
+ * @param can_frame where to put the CAN bus frame.
+ */
+void
+mcp2515_wire_frame_decode(const pi_mcp2515_wire_frame_t *wire_frame, pi_mcp2515_can_frame_t *can_frame)
+{
+	wire_decode(wire_frame->regs, can_frame);
+}
+
+/**
+ * @brief Encode an array of CAN bus frames as wire frames.
+ *
+ * @param can_frames the CAN bus frames.
+ * @param wire_frames where to put the wire frames, which must not overlap @p can_frames.
+ * @param n how many frames to encode.
+ */
+void
+mcp2515_wire_frame_encode_batch(const pi_mcp2515_can_frame_t *restrict can_frames,
+    pi_mcp2515_wire_frame_t *restrict wire_frames, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		wire_encode(&can_frames[i], wire_frames[i].regs);
+}
+
+/**
+ * @brief Decode an array of wire frames.
+ *
+ * @param wire_frames the wire frames.
+ * @param can_frames where to put the CAN bus frames, which must not overlap @p wire_frames.
+ * @param n how many frames to decode.
+ */
+void
+mcp2515_wire_frame_decode_batch(const pi_mcp2515_wire_frame_t *restrict wire_frames,
+    pi_mcp2515_can_frame_t *restrict can_frames, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		wire_decode(wire_frames[i].regs, &can_frames[i]);
+}
+/** @} */
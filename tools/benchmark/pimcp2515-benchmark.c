@@ -0,0 +1,229 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <pi_MCP2515.h>
+
+#include "pimcp2515-benchmark.h"
+
+static volatile bool bench_sink; /* Keeps lookups whose result isn't needed from being optimised away. */
+
+static uint64_t	now_nsec(void);
+static void	bench_run(pi_mcp2515_t *, long);
+static void	bench_run_loopback(pi_mcp2515_t *, long);
+static void	bench_run_sw_filter(pi_mcp2515_t *, long);
+
+static uint64_t
+now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+/* Run each of the hot path operations for the requested number of iterations and print the time per operation. */
+static void
+bench_run(pi_mcp2515_t *pi_mcp2515, long iterations)
+{
+	mcp2515_batch_t batch;
+	uint64_t start;
+	uint8_t buf[3];
+	long i;
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++)
+		mcp2515_status(pi_mcp2515);
+	PRINT_BENCH("READ STATUS", iterations, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++)
+		mcp2515_register_read(pi_mcp2515, buf, 1, PI_MCP2515_RGSTR_CANINTF);
+	PRINT_BENCH("READ (1 byte)", iterations, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++)
+		mcp2515_register_read(pi_mcp2515, buf, 3, PI_MCP2515_RGSTR_CNF3);
+	PRINT_BENCH("READ (3 bytes)", iterations, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++)
+		mcp2515_register_bitmod(pi_mcp2515, 0, PI_MCP2515_CANINTF_ERRIF, PI_MCP2515_RGSTR_CANINTF);
+	PRINT_BENCH("BIT MODIFY", iterations, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++) {
+		mcp2515_batch_init(&batch);
+		mcp2515_batch_status(&batch, &buf[0]);
+		mcp2515_batch_register_read(&batch, &buf[1], 1, PI_MCP2515_RGSTR_CANINTF);
+		mcp2515_batch_register_read(&batch, &buf[2], 1, PI_MCP2515_RGSTR_EFLG);
+		mcp2515_batch_register_bitmod(&batch, 0, PI_MCP2515_CANINTF_ERRIF, PI_MCP2515_RGSTR_CANINTF);
+		mcp2515_batch_flush(pi_mcp2515, &batch);
+	}
+	PRINT_BENCH("BATCH (4 commands)", iterations, now_nsec() - start);
+}
+
+/* Send a frame and read it back in loopback mode, for the cost of a full round trip through the library. */
+static void
+bench_run_loopback(pi_mcp2515_t *pi_mcp2515, long iterations)
+{
+	pi_mcp2515_can_frame_t frame = { .id = 0x123, .dlc = 8, .payload = { 1, 2, 3, 4, 5, 6, 7, 8 } };
+	pi_mcp2515_can_frame_t rx_frame;
+	uint64_t start;
+	long i;
+
+	if (mcp2515_reqop(pi_mcp2515, PI_MCP2515_REQOP_LOOPBACK)) {
+		printf("  %-28s unavailable\n", "SEND + READ (loopback)");
+		return;
+	}
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++) {
+		mcp2515_can_message_send(pi_mcp2515, &frame);
+		mcp2515_can_message_read(pi_mcp2515, &rx_frame);
+	}
+	PRINT_BENCH("SEND + READ (loopback)", iterations, now_nsec() - start);
+
+	mcp2515_reqop(pi_mcp2515, PI_MCP2515_REQOP_CONFIG);
+}
+
+/* Look up IDs in the software filter, which is purely in memory, with a quarter of the IDs looked up accepted. */
+static void
+bench_run_sw_filter(pi_mcp2515_t *pi_mcp2515, long iterations)
+{
+	pi_mcp2515_filter_range_t range = { .first = 0x100, .last = 0x2FF, .extended_id = false };
+	uint64_t start;
+	uint32_t id;
+	long i;
+
+	if (mcp2515_sw_filter_init(pi_mcp2515) || mcp2515_sw_filter_add_range(pi_mcp2515, &range)) {
+		printf("  %-28s unavailable\n", "SW FILTER");
+		mcp2515_sw_filter_free(pi_mcp2515);
+		return;
+	}
+	for (id = 0; id < SW_FILTER_BENCH_EXT_IDS; id++) {
+		if (mcp2515_sw_filter_add(pi_mcp2515, 0x18DA0000 + id * 4, true)) {
+			printf("  %-28s unavailable\n", "SW FILTER");
+			mcp2515_sw_filter_free(pi_mcp2515);
+			return;
+		}
+	}
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++)
+		bench_sink = mcp2515_sw_filter_accepts(pi_mcp2515, (uint32_t)i & 0x7FF, false);
+	PRINT_BENCH("SW FILTER (standard)", iterations, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iterations; i++)
+		bench_sink = mcp2515_sw_filter_accepts(pi_mcp2515, 0x18DA0000 + ((uint32_t)i % SW_FILTER_BENCH_EXT_IDS) * 4
+		    + (i & 3), true);
+	PRINT_BENCH("SW FILTER (extended)", iterations, now_nsec() - start);
+
+	mcp2515_sw_filter_free(pi_mcp2515);
+}
+
+/* Benchmark the per-command cost of the SPI hot paths, comparing chip select driven from a GPIO line against the SPI
+ * controller's native chip select. This doesn't need anything on the CAN bus, but does need an MCP2515 attached,
+ * unless the simulated MCP2515 is used to measure the overhead of the library alone.
+ */
+int
+main(int argc, char *argv[])
+{
+	pi_mcp2515_t *pi_mcp2515;
+	long iterations = DEFAULT_ITERATIONS;
+	uint32_t spi_clock = 10000000;
+	int ch, res;
+	bool sim = false;
+	uint8_t cs_pin = 8, spi_channel = 0;
+
+	while ((ch = getopt(argc, argv, "n:c:s:k:S")) != -1) {
+		switch (ch) {
+		case 'n':
+			iterations = strtol(optarg, NULL, 10);
+			break;
+		case 'c':
+			cs_pin = (uint8_t)strtol(optarg, NULL, 10);
+			break;
+		case 's':
+			spi_channel = (uint8_t)strtol(optarg, NULL, 10);
+			break;
+		case 'k':
+			spi_clock = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'S':
+			sim = true;
+			break;
+		default:
+			fprintf(stderr, BENCH_USAGE);
+			return (1);
+		}
+	}
+	if (iterations <= 0) {
+		fprintf(stderr, BENCH_USAGE);
+		return (1);
+	}
+
+	if (sim) {
+		if ((res = mcp2515_init_sim(&pi_mcp2515, 8))) {
+			fprintf(stderr, "mcp2515_init_sim failed: %d\n", res);
+			return (1);
+		}
+		printf("%ld iterations, simulated MCP2515\n\n", iterations);
+		bench_run(pi_mcp2515, iterations);
+		bench_run_loopback(pi_mcp2515, iterations);
+		bench_run_sw_filter(pi_mcp2515, iterations);
+		mcp2515_free(pi_mcp2515);
+
+		return (0);
+	}
+
+	if ((res = mcp2515_init(&pi_mcp2515, spi_channel, 0, 0, 0, cs_pin, spi_clock, 8))) {
+		fprintf(stderr, "mcp2515_init failed: %d\n", res);
+		return (1);
+	}
+	mcp2515_reset(pi_mcp2515);
+
+	printf("%ld iterations, SPI clock %u Hz\n\n", iterations, spi_clock);
+
+	if (mcp2515_conf_spi_native_cs(pi_mcp2515, false) == 0) {
+		printf("GPIO chip select (pin %u):\n", cs_pin);
+		bench_run(pi_mcp2515, iterations);
+		bench_run_loopback(pi_mcp2515, iterations);
+	} else
+		printf("GPIO chip select (pin %u): unavailable\n", cs_pin);
+	printf("\n");
+
+	if (mcp2515_conf_spi_native_cs(pi_mcp2515, true) == 0) {
+		printf("Native chip select:\n");
+		bench_run(pi_mcp2515, iterations);
+		bench_run_loopback(pi_mcp2515, iterations);
+	} else
+		printf("Native chip select: unavailable\n");
+	printf("\n");
+
+	printf("Software filter:\n");
+	bench_run_sw_filter(pi_mcp2515, iterations);
+
+	mcp2515_free(pi_mcp2515);
+
+	return (0);
+}
@@ -0,0 +1,28 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __PIMCP2515_PIMCP2515_BENCHMARK_H__
+#define __PIMCP2515_PIMCP2515_BENCHMARK_H__
+
+#define DEFAULT_ITERATIONS 10000
+
+#define SW_FILTER_BENCH_EXT_IDS 1024 /* How many extended IDs to fill the software filter with. */
+
+#define BENCH_USAGE "usage: piMCP2515-benchmark [-n iterations] [-c cs_pin] [-s spi_channel] [-k spi_clock_hz] [-S]\n"
+
+#define PRINT_BENCH(name, iterations, nsec) printf("  %-28s %10.2f us/op %12.0f ops/s\n", name, \
+    (double)(nsec) / (iterations) / 1000.0, (iterations) * 1000000000.0 / (double)(nsec))
+
+#endif /* __PIMCP2515_PIMCP2515_BENCHMARK_H__ */
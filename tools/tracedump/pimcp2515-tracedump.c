@@ -0,0 +1,170 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pi_MCP2515.h>
+
+#include "pimcp2515-tracedump.h"
+
+static const char	*trace_name(uint16_t);
+static void	trace_print(const pi_mcp2515_trace_event_t *, uint64_t);
+
+static const char *
+trace_name(uint16_t event)
+{
+	switch (event) {
+	case PI_MCP2515_TRACE_SPI:
+		return ("spi");
+	case PI_MCP2515_TRACE_STATUS:
+		return ("status");
+	case PI_MCP2515_TRACE_RX_STATUS:
+		return ("rx_status");
+	case PI_MCP2515_TRACE_RX:
+		return ("rx");
+	case PI_MCP2515_TRACE_TX_LOAD:
+		return ("tx_load");
+	case PI_MCP2515_TRACE_TX_BUSY:
+		return ("tx_busy");
+	case PI_MCP2515_TRACE_TX_FAIL:
+		return ("tx_fail");
+	case PI_MCP2515_TRACE_TX_CLEAR:
+		return ("tx_clear");
+	case PI_MCP2515_TRACE_REQOP:
+		return ("reqop");
+	case PI_MCP2515_TRACE_CNF:
+		return ("cnf");
+	case PI_MCP2515_TRACE_SHADOW:
+		return ("shadow");
+	case PI_MCP2515_TRACE_EFLG:
+		return ("eflg");
+	default:
+		return ("unknown");
+	}
+}
+
+/* Print an event on one line, with its time in microseconds since @p base. */
+static void
+trace_print(const pi_mcp2515_trace_event_t *ev, uint64_t base)
+{
+	const uint32_t *a = ev->args;
+
+	printf("%12.3f %10" PRIu32 " %-10s", (double)(ev->timestamp - base) / 1000.0, ev->seq, trace_name(ev->event));
+
+	switch (ev->event) {
+	case PI_MCP2515_TRACE_SPI:
+		printf(" segs=%" PRIu32 " bytes=%" PRIu32 " res=%" PRId32, a[0], a[1], (int32_t)a[2]);
+		break;
+	case PI_MCP2515_TRACE_STATUS:
+	case PI_MCP2515_TRACE_RX_STATUS:
+	case PI_MCP2515_TRACE_REQOP:
+	case PI_MCP2515_TRACE_EFLG:
+		printf(" 0x%02" PRIx32, a[0]);
+		break;
+	case PI_MCP2515_TRACE_RX:
+	case PI_MCP2515_TRACE_TX_LOAD:
+		printf(" %s%" PRIu32 " id=0x%0*" PRIx32 "%s dlc=%" PRIu32 "%s",
+		    ev->event == PI_MCP2515_TRACE_RX ? "rxb" : "txb", a[0], TRACE_HDR_EXT(a[1]) ? 8 : 3,
+		    TRACE_HDR_ID(a[1]), TRACE_HDR_EXT(a[1]) ? " ext" : "", a[2] & PI_MCP2515_CAN_DLC_RTR_MASK,
+		    a[2] & PI_MCP2515_CAN_DLC_RTR_FLAG ? " rtr" : "");
+		break;
+	case PI_MCP2515_TRACE_TX_BUSY:
+		printf(" free=0x%" PRIx32 " needed=%" PRIu32, a[0], a[1]);
+		break;
+	case PI_MCP2515_TRACE_TX_FAIL:
+		printf(" txb%" PRIu32 " ctrl=0x%02" PRIx32 "%s%s%s", a[0], a[1], a[1] & PI_MCP2515_CTRL_TXERR ? " txerr" : "",
+		    a[1] & PI_MCP2515_CTRL_MLOA ? " mloa" : "", a[1] & PI_MCP2515_CTRL_ABTF ? " abtf" : "");
+		break;
+	case PI_MCP2515_TRACE_TX_CLEAR:
+		printf(" txb%" PRIu32, a[0]);
+		break;
+	case PI_MCP2515_TRACE_CNF:
+		printf(" cnf1=0x%02" PRIx32 " cnf2=0x%02" PRIx32 " cnf3=0x%02" PRIx32, a[0], a[1], a[2]);
+		break;
+	case PI_MCP2515_TRACE_SHADOW:
+		printf(" rgstr=0x%02" PRIx32 " shadow=0x%02" PRIx32 " read=0x%02" PRIx32, a[0], a[1], a[2]);
+		break;
+	default:
+		printf(" 0x%08" PRIx32 " 0x%08" PRIx32 " 0x%08" PRIx32 " 0x%08" PRIx32, a[0], a[1], a[2], a[3]);
+		break;
+	}
+	printf("\n");
+}
+
+/*
+ * Print a trace saved with mcp2515_trace_save, one event per line. Times are in microseconds since the first event,
+ * or with -a, on the monotonic clock they were recorded with. A jump in the sequence numbers shows events which were
+ * overwritten before the trace was saved.
+ */
+int
+main(int argc, char *argv[])
+{
+	pi_mcp2515_trace_header_t header;
+	pi_mcp2515_trace_event_t ev;
+	FILE *f = stdin;
+	uint64_t base = 0;
+	uint32_t i;
+	int ch, res = 1;
+	bool absolute = false;
+
+	while ((ch = getopt(argc, argv, "a")) != -1) {
+		switch (ch) {
+		case 'a':
+			absolute = true;
+			break;
+		default:
+			fprintf(stderr, TRACEDUMP_USAGE);
+			return (1);
+		}
+	}
+	if (argc - optind > 1) {
+		fprintf(stderr, TRACEDUMP_USAGE);
+		return (1);
+	}
+	if (argc - optind == 1 && (f = fopen(argv[optind], "rb")) == NULL) {
+		perror(argv[optind]);
+		return (1);
+	}
+
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != PI_MCP2515_TRACE_MAGIC) {
+		fprintf(stderr, "not a piMCP2515 trace, or saved on a system of a different byte order\n");
+		goto end;
+	}
+	if (header.version != PI_MCP2515_TRACE_VERSION || header.event_size != sizeof(ev)) {
+		fprintf(stderr, "unsupported trace version %u\n", header.version);
+		goto end;
+	}
+
+	for (i = 0; i < header.count; i++) {
+		if (fread(&ev, sizeof(ev), 1, f) != 1) {
+			fprintf(stderr, "trace truncated after %" PRIu32 " of %" PRIu32 " events\n", i, header.count);
+			goto end;
+		}
+		if (i == 0 && !absolute)
+			base = ev.timestamp;
+		trace_print(&ev, base);
+	}
+	res = 0;
+
+end:
+	if (f != stdin)
+		fclose(f);
+
+	return (res);
+}
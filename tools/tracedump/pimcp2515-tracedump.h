@@ -0,0 +1,26 @@
+/* Copyright 2026 Roos Catling-Tate
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with or
+ * without fee is hereby granted, provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS” AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __PIMCP2515_PIMCP2515_TRACEDUMP_H__
+#define __PIMCP2515_PIMCP2515_TRACEDUMP_H__
+
+#define TRACEDUMP_USAGE "usage: piMCP2515-tracedump [-a] [file]\n"
+
+/* The standard or extended ID in the SIDH, SIDL, EID8, and EID0 registers packed into a trace event argument. */
+#define TRACE_HDR_EXT(x) ((x) & 0x00080000)
+#define TRACE_HDR_ID(x) (TRACE_HDR_EXT(x) ? ((x) >> 24) << 21 | ((x) >> 21 & 0x07) << 18 | ((x) >> 16 & 0x03) << 16 \
+    | ((x) & 0xFFFF) : ((x) >> 24) << 3 | ((x) >> 21 & 0x07))
+
+#endif /* __PIMCP2515_PIMCP2515_TRACEDUMP_H__ */